@@ -28,7 +28,9 @@ Address::Address(OffsetPointer* const A, OffsetPointer* const B,
 const Offset& O) : base(B), addressee(A), offset(O) {
   widened = false;
   
-  if(isa<const Argument>(*(B->getPointer()))) argument = true;
+  // unique arguments are bases like allocs
+  if(isa<const Argument>(*(B->getPointer())) 
+  and B->getPointerType() != OffsetPointer::Alloc) argument = true;
   else argument = false;
   
   if(isa<const GlobalVariable>(*(B->getPointer()))) global = true;
@@ -0,0 +1,150 @@
+//===------------- AddressTriples.cpp - Pass definition ----------*- C++ -*-===//
+//
+//             Offset Based Alias Analysis for The LLVM Compiler
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief
+/// The vector kernels are compiled with target attributes and picked at run
+/// time, so obaa does not need to be built with -mavx2 to use them.
+///
+//===----------------------------------------------------------------------===//
+
+// local includes
+#include "AddressTriples.h"
+// libc includes
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define OBAA_X86_KERNELS
+#endif
+
+using namespace llvm;
+
+/// \brief Bytes an access of \p Size bytes covers past its offset
+static int64_t extent(uint64_t Size) {
+  if(Size == 0) return 0;
+  if(Size - 1 > (uint64_t) INT64_MAX) return INT64_MAX;
+  return Size - 1;
+}
+
+/// \brief \p X + \p Y saturated to the int64_t range, \p Y is not negative
+static int64_t addSat(int64_t X, int64_t Y) {
+  return X > INT64_MAX - Y ? INT64_MAX : X + Y;
+}
+
+/// \brief \p X - \p Y saturated to the int64_t range, \p Y is not negative
+static int64_t subSat(int64_t X, int64_t Y) {
+  return X < INT64_MIN + Y ? INT64_MIN : X - Y;
+}
+
+/// \brief Scalar check of the address \p Base + [\p Lo, \p Hi] against B
+/// starting at the \p First address of B. The bounds are already widened
+/// by the access sizes, so B's offsets are compared as they are.
+static bool conflictsScalar(int64_t Base, int64_t Lo, int64_t Hi,
+const AddressTriples& B, unsigned First) {
+  for(unsigned j = First, je = B.size(); j < je; j++) {
+    if(Base == B.bases[j]) {
+      if(Lo <= B.his[j] and B.los[j] <= Hi) return true;
+    }
+    else if(Base < 0 or B.bases[j] < 0) return true;
+  }
+  return false;
+}
+
+// The kernels widen each address of A to [lo - (SizeB - 1), hi + SizeA - 1]
+// once, which is the same as comparing [lo, hi + SizeA) with every
+// [lo', hi' + SizeB) of B.
+
+static bool mayOverlapScalar(const AddressTriples& A, int64_t ExtA, 
+const AddressTriples& B, int64_t ExtB) {
+  for(unsigned i = 0, ie = A.size(); i < ie; i++)
+    if(conflictsScalar(A.bases[i], subSat(A.los[i], ExtB), 
+    addSat(A.his[i], ExtA), B, 0)) 
+      return true;
+  return false;
+}
+
+#ifdef OBAA_X86_KERNELS
+__attribute__((target("avx2")))
+static bool mayOverlapAVX2(const AddressTriples& A, int64_t ExtA, 
+const AddressTriples& B, int64_t ExtB) {
+  const unsigned n = B.size(), vn = n & ~3u;
+  const __m256i zero = _mm256_setzero_si256();
+  for(unsigned i = 0, ie = A.size(); i < ie; i++) {
+    const int64_t a_lo = subSat(A.los[i], ExtB), a_hi = addSat(A.his[i], ExtA);
+    const __m256i base = _mm256_set1_epi64x(A.bases[i]);
+    const __m256i lo = _mm256_set1_epi64x(a_lo);
+    const __m256i hi = _mm256_set1_epi64x(a_hi);
+    const __m256i unk = A.bases[i] < 0 ? _mm256_set1_epi64x(-1) : zero;
+    for(unsigned j = 0; j < vn; j += 4) {
+      __m256i b_base = _mm256_loadu_si256((const __m256i*) &B.bases[j]);
+      __m256i b_lo = _mm256_loadu_si256((const __m256i*) &B.los[j]);
+      __m256i b_hi = _mm256_loadu_si256((const __m256i*) &B.his[j]);
+      __m256i same = _mm256_cmpeq_epi64(base, b_base);
+      __m256i apart = _mm256_or_si256(_mm256_cmpgt_epi64(lo, b_hi),
+        _mm256_cmpgt_epi64(b_lo, hi));
+      __m256i b_unk = _mm256_or_si256(unk, _mm256_cmpgt_epi64(zero, b_base));
+      // same base and overlapping offsets, or different bases and unknown
+      __m256i conflict = _mm256_or_si256(_mm256_andnot_si256(apart, same),
+        _mm256_andnot_si256(same, b_unk));
+      if(!_mm256_testz_si256(conflict, conflict)) return true;
+    }
+    if(conflictsScalar(A.bases[i], a_lo, a_hi, B, vn)) return true;
+  }
+  return false;
+}
+
+__attribute__((target("sse4.2")))
+static bool mayOverlapSSE42(const AddressTriples& A, int64_t ExtA, 
+const AddressTriples& B, int64_t ExtB) {
+  const unsigned n = B.size(), vn = n & ~1u;
+  const __m128i zero = _mm_setzero_si128();
+  for(unsigned i = 0, ie = A.size(); i < ie; i++) {
+    const int64_t a_lo = subSat(A.los[i], ExtB), a_hi = addSat(A.his[i], ExtA);
+    const __m128i base = _mm_set1_epi64x(A.bases[i]);
+    const __m128i lo = _mm_set1_epi64x(a_lo);
+    const __m128i hi = _mm_set1_epi64x(a_hi);
+    const __m128i unk = A.bases[i] < 0 ? _mm_set1_epi64x(-1) : zero;
+    for(unsigned j = 0; j < vn; j += 2) {
+      __m128i b_base = _mm_loadu_si128((const __m128i*) &B.bases[j]);
+      __m128i b_lo = _mm_loadu_si128((const __m128i*) &B.los[j]);
+      __m128i b_hi = _mm_loadu_si128((const __m128i*) &B.his[j]);
+      __m128i same = _mm_cmpeq_epi64(base, b_base);
+      __m128i apart = _mm_or_si128(_mm_cmpgt_epi64(lo, b_hi),
+        _mm_cmpgt_epi64(b_lo, hi));
+      __m128i b_unk = _mm_or_si128(unk, _mm_cmpgt_epi64(zero, b_base));
+      // same base and overlapping offsets, or different bases and unknown
+      __m128i conflict = _mm_or_si128(_mm_andnot_si128(apart, same),
+        _mm_andnot_si128(same, b_unk));
+      if(!_mm_testz_si128(conflict, conflict)) return true;
+    }
+    if(conflictsScalar(A.bases[i], a_lo, a_hi, B, vn)) return true;
+  }
+  return false;
+}
+#endif
+
+typedef bool (*OverlapKernel)(const AddressTriples&, int64_t, 
+  const AddressTriples&, int64_t);
+
+/// \brief Picks the widest kernel the host supports
+static OverlapKernel selectKernel() {
+#ifdef OBAA_X86_KERNELS
+  __builtin_cpu_init();
+  if(__builtin_cpu_supports("avx2")) return &mayOverlapAVX2;
+  if(__builtin_cpu_supports("sse4.2")) return &mayOverlapSSE42;
+#endif
+  return &mayOverlapScalar;
+}
+
+/// \brief Answers true if an access of \p SizeA bytes through some address
+/// of \p A and one of \p SizeB bytes through some address of \p B may
+/// overlap
+bool llvm::mayOverlap(const AddressTriples& A, uint64_t SizeA, 
+const AddressTriples& B, uint64_t SizeB) {
+  static const OverlapKernel kernel = selectKernel();
+  //the longer set is streamed through the vector lanes
+  if(A.size() > B.size()) return kernel(B, extent(SizeB), A, extent(SizeA));
+  return kernel(A, extent(SizeA), B, extent(SizeB));
+}
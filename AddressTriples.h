@@ -0,0 +1,58 @@
+//===--------------- AddressTriples.h - Pass definition ----------*- C++ -*-===//
+//
+//             Offset Based Alias Analysis for The LLVM Compiler
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// This file contains the declaration of the AddressTriples structure. After
+/// the dependence graph is solved, each address of a pointer reduces to a
+/// (base, lo, hi) triple. The triples of a pointer are kept as a structure of
+/// arrays so two pointers can be compared for overlap with vector
+/// instructions instead of one virtual offset comparison per address pair.
+///
+//===----------------------------------------------------------------------===//
+#ifndef __ADDRESS_TRIPLES_H__
+#define __ADDRESS_TRIPLES_H__
+
+// libc includes
+#include <cstdint>
+#include <vector>
+
+namespace llvm {
+
+/// \brief Structure of arrays with the base identifier and the offset bounds
+/// of each address of a pointer. Bases that are unknown pointers have
+/// negative identifiers.
+struct AddressTriples {
+  std::vector<int64_t> bases;
+  std::vector<int64_t> los;
+  std::vector<int64_t> his;
+
+  /// \brief Adds the address \p Base + [\p Lo, \p Hi]
+  void add(int64_t Base, int64_t Lo, int64_t Hi) {
+    bases.push_back(Base);
+    los.push_back(Lo);
+    his.push_back(Hi);
+  }
+  
+  unsigned size() const { return bases.size(); }
+  
+  void clear() {
+    bases.clear();
+    los.clear();
+    his.clear();
+  }
+};
+
+/// \brief Answers true if an access of \p SizeA bytes through some address
+/// of \p A and one of \p SizeB bytes through some address of \p B may
+/// overlap: they have the same base and overlapping byte intervals 
+/// [lo, hi + size), or different bases one of which is unknown. Unknown 
+/// sizes are ~0. Uses AVX2 or SSE4.2 when the host supports them.
+bool mayOverlap(const AddressTriples& A, uint64_t SizeA, 
+  const AddressTriples& B, uint64_t SizeB);
+
+}
+
+#endif
@@ -0,0 +1,122 @@
+//===---------- AliasScopeExport.cpp - Pass definition ----------*- C++ -*-===//
+//
+//             Offset Based Alias Analysis for The LLVM Compiler
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief This file contains the definition of the AliasScopeExport pass.
+///
+//===----------------------------------------------------------------------===//
+#define DEBUG_TYPE "obaa-scopes"
+
+// local includes
+#include "AliasScopeExport.h"
+#include "OffsetBasedAliasAnalysis.h"
+// llvm includes
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Analysis/AliasAnalysis.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/MDBuilder.h"
+#include "llvm/IR/Metadata.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/CommandLine.h"
+// STL includes
+#include <vector>
+
+STATISTIC(NumScopedAccesses, "Number of accesses given an alias scope");
+STATISTIC(NumNoAliasPairs, "Number of access pairs exported as noalias");
+
+using namespace llvm;
+
+static cl::opt<unsigned> MaxAccesses("obaa-scopes-max-accesses",
+  cl::desc("Maximum number of loads and stores of a function to export"),
+  cl::init(512));
+
+char AliasScopeExport::ID = 0;
+
+static RegisterPass<AliasScopeExport> X("obaa-scopes",
+"Export Offset based Alias Analysis results as scoped noalias metadata",
+false, false);
+
+void AliasScopeExport::getAnalysisUsage(AnalysisUsage &AU) const {
+  AU.addRequired<OffsetBasedAliasAnalysis>();
+  AU.addPreserved<OffsetBasedAliasAnalysis>();
+  AU.setPreservesCFG();
+}
+
+bool AliasScopeExport::runOnModule(Module &M) {
+  OffsetBasedAliasAnalysis &OBAA = getAnalysis<OffsetBasedAliasAnalysis>();
+  bool changed = false;
+  for(auto F = M.begin(), Fe = M.end(); F != Fe; F++)
+    if(!F->isDeclaration())
+      changed |= exportFunction(*F, OBAA);
+  return changed;
+}
+
+/// \brief Exports the facts of a single function. The scopes live in a
+/// domain of the function, so the inliner clones them at each call site.
+/// Scoped noalias holds across every execution of both accesses, e.g. 
+/// across loop iterations, so only facts about the accessed objects are 
+/// exported. Offsets, zones and local trees relate two accesses in the same
+/// iteration only and are left out.
+bool AliasScopeExport::exportFunction(Function &F, 
+OffsetBasedAliasAnalysis &OBAA) {
+  std::vector<Instruction*> accesses;
+  std::vector<MemoryLocation> locs;
+  for (inst_iterator I = inst_begin(F), E = inst_end(F); I != E; ++I) {
+    if(LoadInst* l = dyn_cast<LoadInst>(&*I)) {
+      accesses.push_back(l);
+      locs.push_back(MemoryLocation::get(l));
+    }
+    else if(StoreInst* s = dyn_cast<StoreInst>(&*I)) {
+      accesses.push_back(s);
+      locs.push_back(MemoryLocation::get(s));
+    }
+  }
+  const unsigned n = accesses.size();
+  if(n < 2 or n > MaxAccesses) return false;
+  
+  AliasMatrix matrix = OBAA.aliasMatrix(locs, true);
+  
+  // Only accesses disjoint from some other access get a scope
+  std::vector<bool> scoped(n, false);
+  for(unsigned i = 0; i < n; i++)
+    for(unsigned j = i + 1; j < n; j++)
+      if(!matrix.mayAlias(i, j)) {
+        scoped[i] = scoped[j] = true;
+        NumNoAliasPairs++;
+      }
+  
+  MDBuilder MDB(F.getContext());
+  MDNode* domain = MDB.createAnonymousAliasScopeDomain(F.getName());
+  std::vector<MDNode*> scopes(n, NULL);
+  for(unsigned i = 0; i < n; i++)
+    if(scoped[i]) {
+      scopes[i] = MDB.createAnonymousAliasScope(domain);
+      NumScopedAccesses++;
+    }
+  
+  bool changed = false;
+  for(unsigned i = 0; i < n; i++) {
+    if(!scoped[i]) continue;
+    Instruction* I = accesses[i];
+    std::vector<Metadata*> noalias;
+    for(unsigned j = 0; j < n; j++)
+      if(j != i and scoped[j] and !matrix.mayAlias(i, j))
+        noalias.push_back(scopes[j]);
+    
+    // Scopes of other domains are kept
+    Metadata* own = scopes[i];
+    I->setMetadata(LLVMContext::MD_alias_scope, MDNode::concatenate(
+      I->getMetadata(LLVMContext::MD_alias_scope), 
+      MDNode::get(F.getContext(), own)));
+    I->setMetadata(LLVMContext::MD_noalias, MDNode::concatenate(
+      I->getMetadata(LLVMContext::MD_noalias), 
+      MDNode::get(F.getContext(), noalias)));
+    changed = true;
+  }
+  return changed;
+}
@@ -0,0 +1,44 @@
+//===------------ AliasScopeExport.h - Pass definition ----------*- C++ -*-===//
+//
+//             Offset Based Alias Analysis for The LLVM Compiler
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// This file contains the declaration of the AliasScopeExport pass. It runs
+/// after the Offset Based Alias Analysis and writes the disjointness it
+/// proved between the objects the loads and stores of each function access
+/// as !alias.scope and !noalias metadata, so later passes keep it without
+/// running obaa.
+///
+//===----------------------------------------------------------------------===//
+#ifndef __ALIAS_SCOPE_EXPORT_H__
+#define __ALIAS_SCOPE_EXPORT_H__
+
+// llvm includes
+#include "llvm/Pass.h"
+
+namespace llvm {
+
+// Forward declarations
+class OffsetBasedAliasAnalysis;
+
+/// \brief Gives each load and store that obaa proved disjoint from another
+/// access of its function a scope of its own, and lists in its !noalias the
+/// scopes of the accesses it cannot alias
+class AliasScopeExport : public ModulePass {
+public:
+  static char ID; // Class identification, replacement for typeinfo
+  AliasScopeExport() : ModulePass(ID) {}
+  void getAnalysisUsage(AnalysisUsage &AU) const override;
+  bool runOnModule(Module &M) override;
+
+private:
+  /// \brief Exports the facts of a single function, answers true if any
+  /// metadata was added
+  bool exportFunction(Function &F, OffsetBasedAliasAnalysis &OBAA);
+};
+
+}
+
+#endif
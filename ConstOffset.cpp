@@ -0,0 +1,173 @@
+//===--------------- ConstOffset.cpp - Pass definition ----------*- C++ -*-===//
+//
+//             Offset Based Alias Analysis for The LLVM Compiler
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief
+///
+//===----------------------------------------------------------------------===//
+
+// project's includes
+#include "ConstOffset.h"
+#include "OffsetBasedAliasAnalysis.h"
+// llvm's includes
+#include "llvm/ADT/APInt.h"
+#include "llvm/Analysis/MemoryLocation.h"
+#include "llvm/IR/DataLayout.h"
+#include "llvm/IR/Operator.h"
+#include "llvm/Support/Casting.h"
+// libc includes
+#include <algorithm>
+
+using namespace llvm;
+
+static RegisterOffsetRepresentation<ConstOffset> X("const",
+  "Offsets as byte intervals of constant getelementptr indices", 1);
+
+const DataLayout* ConstOffset::DL = NULL;
+
+/// \brief Saturating addition of interval bounds
+static int64_t addBounds(int64_t A, int64_t B) {
+  if(A == INT64_MIN or B == INT64_MIN) return INT64_MIN;
+  if(A == INT64_MAX or B == INT64_MAX) return INT64_MAX;
+  if(B > 0 and A > INT64_MAX - B) return INT64_MAX;
+  if(B < 0 and A < INT64_MIN - B) return INT64_MIN;
+  return A + B;
+}
+
+ConstOffset::ConstOffset() : lo(0), hi(0) { }
+
+/// \brief Builds \p pointer's offset using \p base. Only getelementptrs
+/// with constant indices give a bounded offset.
+ConstOffset::ConstOffset(const Value* Pointer, const Value* Base) 
+: lo(INT64_MIN), hi(INT64_MAX) {
+  const GEPOperator* gep = dyn_cast<GEPOperator>(Pointer);
+  if(DL == NULL or gep == NULL or gep->getPointerOperand() != Base) return;
+  
+  APInt offset(DL->getPointerTypeSizeInBits(gep->getType()), 0);
+  if(gep->accumulateConstantOffset(*DL, offset)) {
+    lo = offset.getSExtValue();
+    hi = lo;
+  }
+}
+
+/// \brief Builds the interval [\p Lo, \p Hi]
+ConstOffset::ConstOffset(int64_t Lo, int64_t Hi) : lo(Lo), hi(Hi) { }
+
+/// \brief Destructor 
+ConstOffset::~ConstOffset() { }
+
+/// \brief Returns a copy of the represented offset
+ConstOffset* ConstOffset::copy() { return new ConstOffset(lo, hi); }
+
+/// \brief Adds two offsets of the respective representation
+ConstOffset* ConstOffset::add(OffsetRepresentation* Other) {
+  ConstOffset* o = (ConstOffset*) Other;
+  return new ConstOffset(addBounds(lo, o->lo), addBounds(hi, o->hi));
+}
+
+/// \brief Answers true if the accessed byte intervals are disjoint: 
+/// [lo, hi + Size) ends before the other starts, or the other way around
+bool ConstOffset::disjoint(OffsetRepresentation* Other, uint64_t Size, 
+uint64_t OtherSize) {
+  ConstOffset* o = (ConstOffset*) Other;
+  if(Size == MemoryLocation::UnknownSize 
+  or OtherSize == MemoryLocation::UnknownSize)
+    return false;
+  if(hi != INT64_MAX and o->lo != INT64_MIN and hi < o->lo
+  and (uint64_t) o->lo - (uint64_t) hi >= Size)
+    return true;
+  if(o->hi != INT64_MAX and lo != INT64_MIN and o->hi < lo
+  and (uint64_t) lo - (uint64_t) o->hi >= OtherSize)
+    return true;
+  return false;
+}
+
+/// \brief Narrows the offset of the respective representation
+ConstOffset* ConstOffset::narrow(CmpInst::Predicate Cmp, 
+OffsetRepresentation* Other) {
+  ConstOffset* o = (ConstOffset*) Other;
+  int64_t new_lo = lo, new_hi = hi;
+  
+  if(Cmp == CmpInst::ICMP_EQ) {
+    new_lo = std::max(lo, o->lo);
+    new_hi = std::min(hi, o->hi);
+  }
+  else if(Cmp == CmpInst::ICMP_SLT) {
+    new_hi = std::min(hi, addBounds(o->hi, -1));
+  }
+  else if(Cmp == CmpInst::ICMP_SLE) {
+    new_hi = std::min(hi, o->hi);
+  }
+  else if(Cmp == CmpInst::ICMP_SGT) {
+    new_lo = std::max(lo, addBounds(o->lo, 1));
+  }
+  else if(Cmp == CmpInst::ICMP_SGE) {
+    new_lo = std::max(lo, o->lo);
+  }
+  
+  //An empty interval means the comparison never holds, keep the old one
+  if(new_lo <= new_hi) {
+    lo = new_lo;
+    hi = new_hi;
+  }
+  return this;
+}
+
+/// \brief Widens the offset of the respective representation, Before and 
+///   After are given so its possible to calculate direction of growth.
+ConstOffset* ConstOffset::widen(OffsetRepresentation* Before,
+OffsetRepresentation* After) {
+  ConstOffset* b = (ConstOffset*) Before;
+  ConstOffset* a = (ConstOffset*) After;
+  if(a->lo < b->lo) lo = INT64_MIN;
+  if(a->hi > b->hi) hi = INT64_MAX;
+  return this;
+}
+
+/// \brief Gives the interval bounds
+bool ConstOffset::getBounds(int64_t& Lo, int64_t& Hi) {
+  Lo = lo;
+  Hi = hi;
+  return true;
+}
+
+/// \brief Intersects the interval with [Lo, Hi]. An empty intersection is
+/// left alone, it only happens on out of bounds pointers.
+void ConstOffset::clamp(int64_t Lo, int64_t Hi) {
+  int64_t new_lo = std::max(lo, Lo);
+  int64_t new_hi = std::min(hi, Hi);
+  if(new_lo <= new_hi) {
+    lo = new_lo;
+    hi = new_hi;
+  }
+}
+
+/// \brief Prints the offset representation
+void ConstOffset::print() {
+  errs() << "[";
+  if(lo == INT64_MIN) errs() << "-inf";
+  else errs() << lo;
+  errs() << ", ";
+  if(hi == INT64_MAX) errs() << "+inf";
+  else errs() << hi;
+  errs() << "]";
+}
+
+/// \brief Prints the offset to a file
+void ConstOffset::print(raw_fd_ostream& fs) {
+  fs << "[";
+  if(lo == INT64_MIN) fs << "-inf";
+  else fs << lo;
+  fs << ", ";
+  if(hi == INT64_MAX) fs << "+inf";
+  else fs << hi;
+  fs << "]";
+}
+
+/// \brief Fetches the module's data layout from obaa
+void ConstOffset::initialization(OffsetBasedAliasAnalysis* Analysis) {
+  DL = Analysis->getDataLayout();
+}
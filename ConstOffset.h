@@ -0,0 +1,94 @@
+//===----------------- ConstOffset.h - Pass definition ----------*- C++ -*-===//
+//
+//             Offset Based Alias Analysis for The LLVM Compiler
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// This file contains the declaration of the ConstOffset class. It is an
+/// offset representation that keeps byte intervals built only from constant
+/// getelementptr indices. It requires no other analysis, which makes it the
+/// cheapest representation available to obaa.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef __CONST_OFFSET_H__
+#define __CONST_OFFSET_H__
+
+// project's includes
+#include "Offset.h"
+// llvm's includes
+#include "llvm/IR/InstrTypes.h"
+#include "llvm/Support/raw_ostream.h"
+// libc includes
+#include <cstdint>
+
+namespace llvm {
+
+// Forward declarations
+class AnalysisUsage;
+class DataLayout;
+class Value;
+class OffsetBasedAliasAnalysis;
+
+/// \brief Offset representation that uses constant byte intervals
+class ConstOffset : public OffsetRepresentation {
+  
+public:
+  ConstOffset();
+  
+  /// \brief Builds \p pointer's offset using \p base 
+  ConstOffset(const Value* Pointer, const Value* Base);
+  
+  /// \brief Builds the interval [\p Lo, \p Hi]
+  ConstOffset(int64_t Lo, int64_t Hi);
+  
+  /// \brief Destructor 
+  ~ConstOffset() override;
+  
+  /// \brief Returns a copy of the represented offset
+  ConstOffset* copy() override;
+  
+  /// \brief Adds two offsets of the respective representation
+  ConstOffset* add(OffsetRepresentation* Other) override;
+  
+  /// \brief Answers true if the accessed byte intervals are disjoint
+  bool disjoint(OffsetRepresentation* Other, uint64_t Size, 
+    uint64_t OtherSize) override;
+  
+  /// \brief Narrows the offset of the respective representation
+  ConstOffset* narrow(CmpInst::Predicate Cmp, 
+    OffsetRepresentation* Other) override;
+  
+  /// \brief Widens the offset of the respective representation, Before and 
+  ///   After are given so its possible to calculate direction of growth.
+  ConstOffset* widen(OffsetRepresentation* Before,
+    OffsetRepresentation* After) override;
+  
+  /// \brief Gives the interval bounds
+  bool getBounds(int64_t& Lo, int64_t& Hi) override;
+  
+  /// \brief Intersects the interval with [Lo, Hi]
+  void clamp(int64_t Lo, int64_t Hi) override;
+  
+  /// \brief Prints the offset representation
+  void print() override;
+  /// \brief Prints the offset to a file
+  void print(raw_fd_ostream& fs) override;
+  
+  /// \brief Fetches the module's data layout from obaa
+  static void initialization(OffsetBasedAliasAnalysis* Analysis);
+
+private:
+  static const DataLayout* DL;
+  /// \brief Interval bounds, INT64_MIN and INT64_MAX stand for infinities
+  int64_t lo;
+  int64_t hi;
+};
+
+}
+
+#endif
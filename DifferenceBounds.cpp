@@ -0,0 +1,263 @@
+//===----------- DifferenceBounds.cpp - Pass definition ----------*- C++ -*-===//
+//
+//             Offset Based Alias Analysis for The LLVM Compiler
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief
+/// Pointers in vSSA form have a single definition, and sigmas give the
+/// values a comparison is known to hold for new names, so every constraint
+/// collected here holds wherever both of its pointers are defined.
+///
+//===----------------------------------------------------------------------===//
+
+// local includes
+#include "DifferenceBounds.h"
+// llvm includes
+#include "llvm/ADT/APInt.h"
+#include "llvm/IR/BasicBlock.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/DataLayout.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Operator.h"
+#include "llvm/Support/Casting.h"
+#include "llvm/Support/raw_ostream.h"
+// STL includes
+#include <algorithm>
+#include <set>
+
+using namespace llvm;
+
+/// \brief Saturating addition of two bounds
+static int64_t addBounds(int64_t A, int64_t B) {
+  if(A == DifferenceBounds::Inf or B == DifferenceBounds::Inf)
+    return DifferenceBounds::Inf;
+  if(B < 0 and A < INT64_MIN - B) return INT64_MIN;
+  if(B > 0 and A > INT64_MAX - 1 - B) return DifferenceBounds::Inf;
+  return A + B;
+}
+
+/// \brief Finds the representative of \p I in the union find \p Parent
+static unsigned findSet(std::vector<unsigned>& Parent, unsigned I) {
+  while(Parent[I] != I) {
+    Parent[I] = Parent[Parent[I]];
+    I = Parent[I];
+  }
+  return I;
+}
+
+DifferenceBounds::DifferenceBounds(unsigned MaxVars) : max_vars(MaxVars) { }
+
+DifferenceBounds::~DifferenceBounds() {
+  for(auto z : zones) delete z;
+}
+
+/// \brief Collects the constraints of \p F and closes each group
+void DifferenceBounds::build(const Function& F, const DataLayout& DL) {
+  std::vector<Constraint> cs;
+  std::set<const Value*> seen;
+  
+  for(auto I = inst_begin(F), E = inst_end(F); I != E; ++I) {
+    const Instruction* i = &(*I);
+    if(i->getType()->isPointerTy() and seen.insert(i).second) {
+      addDefinition(i, DL, cs);
+      if(const PHINode* phi = dyn_cast<PHINode>(i))
+        if(phi->getName().startswith("vSSA_sigma"))
+          addSigma(phi, cs);
+    }
+    //constant expressions are pointers of the function as well
+    for(auto oi = i->op_begin(), oe = i->op_end(); oi != oe; oi++)
+      if(isa<ConstantExpr>(*oi) and (*oi)->getType()->isPointerTy()
+      and seen.insert(*oi).second)
+        addDefinition(*oi, DL, cs);
+  }
+  if(cs.empty()) return;
+  
+  //Related pointers are grouped with a union find
+  std::map<const Value*, unsigned> ids;
+  std::vector<const Value*> values;
+  for(auto& c : cs) {
+    for(const Value* v : {c.a, c.b})
+      if(ids.insert(std::make_pair(v, (unsigned) values.size())).second)
+        values.push_back(v);
+  }
+  std::vector<unsigned> parent(values.size());
+  for(unsigned i = 0; i < parent.size(); i++) parent[i] = i;
+  for(auto& c : cs)
+    parent[findSet(parent, ids[c.a])] = findSet(parent, ids[c.b]);
+  
+  std::map<unsigned, Zone*> groups;
+  std::map<unsigned, unsigned> group_sizes;
+  for(unsigned i = 0; i < values.size(); i++)
+    group_sizes[findSet(parent, i)]++;
+  for(unsigned i = 0; i < values.size(); i++) {
+    unsigned root = findSet(parent, i);
+    if(group_sizes[root] > max_vars) continue;
+    if(groups.find(root) == groups.end()) {
+      groups[root] = new Zone();
+      zones.push_back(groups[root]);
+    }
+    Zone* z = groups[root];
+    index[values[i]] = std::make_pair(z, (unsigned) z->vars.size());
+    z->vars.push_back(values[i]);
+  }
+  
+  for(auto g : groups) {
+    Zone* z = g.second;
+    unsigned n = z->vars.size();
+    z->matrix.assign(n*n, Inf);
+    for(unsigned i = 0; i < n; i++) z->at(i, i) = 0;
+  }
+  for(auto& c : cs) {
+    auto ia = index.find(c.a);
+    if(ia == index.end()) continue;
+    Zone* z = ia->second.first;
+    unsigned a = ia->second.second;
+    unsigned b = index[c.b].second;
+    if(c.c < z->at(a, b)) z->at(a, b) = c.c;
+  }
+  
+  //Floyd-Warshall closure
+  for(auto g : groups) {
+    Zone* z = g.second;
+    unsigned n = z->vars.size();
+    for(unsigned k = 0; k < n; k++)
+      for(unsigned i = 0; i < n; i++) {
+        if(z->at(i, k) == Inf) continue;
+        for(unsigned j = 0; j < n; j++) {
+          int64_t through = addBounds(z->at(i, k), z->at(k, j));
+          if(through < z->at(i, j)) z->at(i, j) = through;
+        }
+      }
+  }
+  
+  //A negative diagonal is a negative cycle, the constraints of the zone
+  // cannot all hold, e.g. on an unreachable path, so nothing is kept of it
+  for(auto g : groups) {
+    Zone* z = g.second;
+    bool infeasible = false;
+    for(unsigned i = 0; i < z->vars.size(); i++)
+      if(z->at(i, i) < 0) infeasible = true;
+    if(!infeasible) continue;
+    for(auto v : z->vars) {
+      auto iv = index.find(v);
+      if(iv != index.end() and iv->second.first == z) index.erase(iv);
+    }
+    zones.erase(std::find(zones.begin(), zones.end(), z));
+    delete z;
+  }
+}
+
+/// \brief Returns an upper bound of \p A - \p B in bytes, Inf if the 
+/// pointers are not related
+int64_t DifferenceBounds::getBound(const Value* A, const Value* B) const {
+  auto ia = index.find(A);
+  auto ib = index.find(B);
+  if(ia == index.end() or ib == index.end()) return Inf;
+  if(ia->second.first != ib->second.first) return Inf;
+  return ia->second.first->at(ia->second.second, ib->second.second);
+}
+
+/// \brief Answers true if the \p SizeA bytes at \p A cannot overlap the
+/// \p SizeB bytes at \p B
+bool DifferenceBounds::disjoint(const Value* A, uint64_t SizeA, 
+const Value* B, uint64_t SizeB) const {
+  // A + SizeA <= B
+  int64_t ab = getBound(A, B);
+  if(ab != Inf and SizeA <= (uint64_t) INT64_MAX and ab <= -(int64_t) SizeA)
+    return true;
+  // B + SizeB <= A
+  int64_t ba = getBound(B, A);
+  if(ba != Inf and SizeB <= (uint64_t) INT64_MAX and ba <= -(int64_t) SizeB)
+    return true;
+  return false;
+}
+
+/// \brief Prints the closed matrices
+void DifferenceBounds::print() const {
+  for(auto z : zones) {
+    errs() << "Zone:\n";
+    for(unsigned i = 0; i < z->vars.size(); i++)
+      for(unsigned j = 0; j < z->vars.size(); j++)
+        if(i != j and z->at(i, j) != Inf)
+          errs() << "  " << z->vars[i]->getName() << " - " 
+            << z->vars[j]->getName() << " <= " << z->at(i, j) << "\n";
+  }
+}
+
+/// \brief Adds the constraints of a value defined by a constant offset or a
+/// cast of another pointer
+void DifferenceBounds::addDefinition(const Value* V, const DataLayout& DL,
+std::vector<Constraint>& Cs) {
+  if(const GEPOperator* gep = dyn_cast<GEPOperator>(V)) {
+    const Value* base = gep->getPointerOperand();
+    APInt offset(DL.getPointerTypeSizeInBits(gep->getType()), 0);
+    if(gep->accumulateConstantOffset(DL, offset)) {
+      int64_t c = offset.getSExtValue();
+      Cs.push_back({V, base, c});
+      Cs.push_back({base, V, -c});
+    }
+  }
+  else if(Operator::getOpcode(V) == Instruction::BitCast) {
+    const Value* base = cast<Operator>(V)->getOperand(0);
+    if(base->getType()->isPointerTy()) {
+      Cs.push_back({V, base, 0});
+      Cs.push_back({base, V, 0});
+    }
+  }
+}
+
+/// \brief Adds the constraints of a sigma and of its branch's comparison
+void DifferenceBounds::addSigma(const Value* Sigma, 
+std::vector<Constraint>& Cs) {
+  const PHINode* sigma = cast<PHINode>(Sigma);
+  const Value* v = sigma->getIncomingValue(0);
+  
+  //a sigma is a copy of its incoming value
+  Cs.push_back({sigma, v, 0});
+  Cs.push_back({v, sigma, 0});
+  
+  const BasicBlock* o_block = sigma->getIncomingBlock(0);
+  const BranchInst* br = dyn_cast<BranchInst>(o_block->getTerminator());
+  if(br == NULL or !br->isConditional()) return;
+  const ICmpInst* cmp_i = dyn_cast<ICmpInst>(br->getCondition());
+  if(cmp_i == NULL) return;
+  
+  CmpInst::Predicate pred = cmp_i->getPredicate();
+  if(sigma->getParent() == br->getSuccessor(1))
+    pred = CmpInst::getInversePredicate(pred);
+  else if(sigma->getParent() != br->getSuccessor(0))
+    return;
+  
+  if(v == cmp_i->getOperand(0))
+    addComparison(pred, sigma, cmp_i->getOperand(1), Cs);
+  else if(v == cmp_i->getOperand(1))
+    addComparison(CmpInst::getSwappedPredicate(pred), sigma, 
+      cmp_i->getOperand(0), Cs);
+}
+
+/// \brief Adds a - b <= c to Cs when \p Pred(a, b) holds
+void DifferenceBounds::addComparison(CmpInst::Predicate Pred, const Value* A,
+const Value* B, std::vector<Constraint>& Cs) {
+  if(!B->getType()->isPointerTy()) return;
+  
+  if(Pred == CmpInst::ICMP_EQ) {
+    Cs.push_back({A, B, 0});
+    Cs.push_back({B, A, 0});
+  }
+  else if(Pred == CmpInst::ICMP_SLT or Pred == CmpInst::ICMP_ULT) {
+    Cs.push_back({A, B, -1});
+  }
+  else if(Pred == CmpInst::ICMP_SLE or Pred == CmpInst::ICMP_ULE) {
+    Cs.push_back({A, B, 0});
+  }
+  else if(Pred == CmpInst::ICMP_SGT or Pred == CmpInst::ICMP_UGT) {
+    Cs.push_back({B, A, -1});
+  }
+  else if(Pred == CmpInst::ICMP_SGE or Pred == CmpInst::ICMP_UGE) {
+    Cs.push_back({B, A, 0});
+  }
+}
@@ -0,0 +1,94 @@
+//===------------- DifferenceBounds.h - Pass definition ----------*- C++ -*-===//
+//
+//             Offset Based Alias Analysis for The LLVM Compiler
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// This file contains the declaration of the DifferenceBounds class. It is a
+/// relational offset domain (a zone) that keeps constraints of the form
+/// a - b <= c between pointers of the same function that share a base, so
+/// the relation given by a comparison such as i < e survives widening. 
+/// Pointers are related by constant getelementptrs, casts, sigmas and the
+/// comparisons the sigmas come from.
+///
+//===----------------------------------------------------------------------===//
+#ifndef __DIFFERENCE_BOUNDS_H__
+#define __DIFFERENCE_BOUNDS_H__
+
+// llvm's includes
+#include "llvm/IR/InstrTypes.h"
+// libc includes
+#include <cstdint>
+#include <map>
+#include <vector>
+
+namespace llvm {
+
+// Forward declarations
+class DataLayout;
+class Function;
+class Value;
+
+/// \brief Difference bound matrices over groups of related pointers
+class DifferenceBounds {
+
+public:
+  /// \brief Bound used when a difference is unconstrained
+  static const int64_t Inf = INT64_MAX;
+
+  /// \brief Groups with more than \p MaxVars pointers are not tracked
+  DifferenceBounds(unsigned MaxVars);
+  ~DifferenceBounds();
+  
+  /// \brief Collects the constraints of \p F and closes each group
+  void build(const Function& F, const DataLayout& DL);
+  
+  /// \brief Returns an upper bound of \p A - \p B in bytes, Inf if the 
+  /// pointers are not related
+  int64_t getBound(const Value* A, const Value* B) const;
+  
+  /// \brief Answers true if the \p SizeA bytes at \p A cannot overlap the
+  /// \p SizeB bytes at \p B
+  bool disjoint(const Value* A, uint64_t SizeA, const Value* B, 
+    uint64_t SizeB) const;
+
+  /// \brief Prints the closed matrices
+  void print() const;
+
+private:
+  /// \brief A constraint Vars[a] - Vars[b] <= c
+  struct Constraint {
+    const Value* a;
+    const Value* b;
+    int64_t c;
+  };
+  /// \brief A closed difference bound matrix over a group of pointers
+  struct Zone {
+    std::vector<const Value*> vars;
+    std::vector<int64_t> matrix;
+    int64_t& at(unsigned I, unsigned J) { return matrix[I*vars.size() + J]; }
+    int64_t at(unsigned I, unsigned J) const {
+      return matrix[I*vars.size() + J];
+    }
+  };
+  
+  const unsigned max_vars;
+  std::vector<Zone*> zones;
+  /// \brief Zone and position of each tracked pointer
+  std::map<const Value*, std::pair<Zone*, unsigned> > index;
+  
+  /// \brief Adds the constraints of a value defined by a constant offset or a
+  /// cast of another pointer
+  void addDefinition(const Value* V, const DataLayout& DL,
+    std::vector<Constraint>& Cs);
+  /// \brief Adds the constraints of a sigma and of its branch's comparison
+  void addSigma(const Value* Sigma, std::vector<Constraint>& Cs);
+  /// \brief Adds a - b <= c to Cs when \p Pred(a, b) holds
+  void addComparison(CmpInst::Predicate Pred, const Value* A, const Value* B,
+    std::vector<Constraint>& Cs);
+};
+
+}
+
+#endif
@@ -0,0 +1,146 @@
+//===----------------- LocalTrees.cpp - Pass definition ----------*- C++ -*-===//
+//
+//             Offset Based Alias Analysis for The LLVM Compiler
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// \brief
+///
+//===----------------------------------------------------------------------===//
+
+// local includes
+#include "LocalTrees.h"
+#include "Address.h"
+#include "OffsetPointer.h"
+// STL includes
+#include <algorithm>
+
+using namespace llvm;
+
+/// \brief Builds the local trees of \p Pointers in a single pass that
+/// visits each parent before its children
+void LocalTrees::build(const std::vector<OffsetPointer*>& Pointers) {
+  euler.clear();
+  sparse.clear();
+  
+  for(auto p : Pointers) {
+    p->local_state = 0;
+    p->local_parent = NULL;
+    if(p->addresses.size() == 1) {
+      OffsetPointer* base = (*(p->addresses.begin()))->getBase();
+      if(base != p) p->local_parent = base;
+    }
+  }
+  for(auto p : Pointers)
+    settle(p);
+  
+  std::map<OffsetPointer*, std::vector<OffsetPointer*> > children;
+  for(auto p : Pointers)
+    if(p->local_parent != NULL)
+      children[p->local_parent].push_back(p);
+  for(auto p : Pointers)
+    if(p->local_parent == NULL)
+      tour(p, children);
+  
+  //sparse table over the depths of the tour
+  sparse.push_back(std::vector<unsigned>(euler.size()));
+  for(unsigned i = 0; i < euler.size(); i++) sparse[0][i] = i;
+  for(unsigned k = 1; (1u << k) <= euler.size(); k++) {
+    const std::vector<unsigned>& prev = sparse[k-1];
+    std::vector<unsigned> level(euler.size() - (1u << k) + 1);
+    for(unsigned i = 0; i < level.size(); i++)
+      level[i] = shallowest(prev[i], prev[i + (1u << (k-1))]);
+    sparse.push_back(level);
+  }
+}
+
+/// \brief Returns the lowest common ancestor of \p A and \p B, or NULL if
+/// they are in different trees
+OffsetPointer* LocalTrees::lca(const OffsetPointer* A, 
+const OffsetPointer* B) const {
+  if(A->local_root != B->local_root or A->local_root == NULL) return NULL;
+  unsigned l = A->euler_first, r = B->euler_first;
+  if(l > r) std::swap(l, r);
+  unsigned k = 0;
+  while((2u << k) <= r - l + 1) k++;
+  return euler[shallowest(sparse[k][l], sparse[k][r - (1u << k) + 1])];
+}
+
+/// \brief Returns the offset of \p P from its ancestor \p Ancestor
+Offset LocalTrees::pathOffset(const OffsetPointer* P, 
+const OffsetPointer* Ancestor) const {
+  Offset offset;
+  for(const OffsetPointer* p = P; p != Ancestor; p = p->local_parent)
+    offset = offset + p->local_edge;
+  return offset;
+}
+
+/// \brief Finds the parent of \p N's ancestors and gives them their root,
+/// depth and offset. A chain that loops back on itself is a lonely loop,
+/// it is broken at its highest pointer, which becomes the root.
+void LocalTrees::settle(OffsetPointer* N) {
+  std::vector<OffsetPointer*> path;
+  OffsetPointer* current = N;
+  while(current != NULL and current->local_state != 2) {
+    if(current->local_state == 1) {
+      auto loop = std::find(path.begin(), path.end(), current);
+      OffsetPointer* root = *std::max_element(loop, path.end());
+      root->local_parent = NULL;
+      //walk again now that the loop is broken
+      for(auto p : path) p->local_state = 0;
+      settle(N);
+      return;
+    }
+    current->local_state = 1;
+    path.push_back(current);
+    current = current->local_parent;
+  }
+  
+  //every parent on the path is settled before its child
+  for(auto i = path.rbegin(), e = path.rend(); i != e; i++) {
+    OffsetPointer* p = *i;
+    OffsetPointer* parent = p->local_parent;
+    if(parent == NULL) {
+      p->local_root = p;
+      p->local_depth = 0;
+      p->local_offset = Offset();
+    } else {
+      p->local_root = parent->local_root;
+      p->local_depth = parent->local_depth + 1;
+      p->local_edge = (*(p->addresses.begin()))->getOffset();
+      p->local_offset = parent->local_offset + p->local_edge;
+    }
+    p->local_state = 2;
+  }
+}
+
+/// \brief Appends the Euler tour of the tree of \p Root
+void LocalTrees::tour(OffsetPointer* Root,
+std::map<OffsetPointer*, std::vector<OffsetPointer*> >& Children) {
+  //explicit stack of (pointer, next child to visit)
+  std::vector<std::pair<OffsetPointer*, unsigned> > stack;
+  Root->euler_first = euler.size();
+  euler.push_back(Root);
+  stack.push_back(std::make_pair(Root, 0u));
+  while(!stack.empty()) {
+    OffsetPointer* p = stack.back().first;
+    unsigned next = stack.back().second;
+    auto c = Children.find(p);
+    if(c != Children.end() and next < c->second.size()) {
+      stack.back().second++;
+      OffsetPointer* child = c->second[next];
+      child->euler_first = euler.size();
+      euler.push_back(child);
+      stack.push_back(std::make_pair(child, 0u));
+    } else {
+      stack.pop_back();
+      if(!stack.empty()) euler.push_back(stack.back().first);
+    }
+  }
+}
+
+/// \brief Position in euler of the shallowest of two positions
+unsigned LocalTrees::shallowest(unsigned I, unsigned J) const {
+  return euler[I]->local_depth <= euler[J]->local_depth ? I : J;
+}
@@ -0,0 +1,66 @@
+//===------------------- LocalTrees.h - Pass definition ----------*- C++ -*-===//
+//
+//             Offset Based Alias Analysis for The LLVM Compiler
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// This file contains the declaration of the LocalTrees class. A pointer
+/// with a single address before the graph is solved is exactly its base plus
+/// an offset, so these edges form a forest, the local trees. Each pointer
+/// keeps its parent, depth and offset from the root of its tree, and an
+/// Euler tour with a sparse table answers lowest common ancestor queries in
+/// constant time.
+///
+//===----------------------------------------------------------------------===//
+#ifndef __LOCAL_TREES_H__
+#define __LOCAL_TREES_H__
+
+// local includes
+#include "Offset.h"
+// libc includes
+#include <map>
+#include <vector>
+
+namespace llvm {
+
+// Forward declarations
+class OffsetPointer;
+
+/// \brief Forest of the pointers' local trees with an LCA index
+class LocalTrees {
+
+public:
+  /// \brief Builds the local trees of \p Pointers in a single pass that
+  /// visits each parent before its children
+  void build(const std::vector<OffsetPointer*>& Pointers);
+  
+  /// \brief Returns the lowest common ancestor of \p A and \p B, or NULL if
+  /// they are in different trees
+  OffsetPointer* lca(const OffsetPointer* A, const OffsetPointer* B) const;
+  
+  /// \brief Returns the offset of \p P from its ancestor \p Ancestor, 
+  /// walking the path between them
+  Offset pathOffset(const OffsetPointer* P, const OffsetPointer* Ancestor)
+    const;
+
+private:
+  /// \brief Euler tour of every tree, one after the other
+  std::vector<OffsetPointer*> euler;
+  /// \brief Levels of the sparse table, level k holds the position of the
+  /// shallowest pointer in euler[i, i + 2^k)
+  std::vector<std::vector<unsigned> > sparse;
+  
+  /// \brief Finds the parent of \p N's ancestors and gives them their root,
+  /// depth and offset
+  void settle(OffsetPointer* N);
+  /// \brief Appends the Euler tour of the tree of \p Root
+  void tour(OffsetPointer* Root, 
+    std::map<OffsetPointer*, std::vector<OffsetPointer*> >& Children);
+  /// \brief Position in euler of the shallowest of two positions
+  unsigned shallowest(unsigned I, unsigned J) const;
+};
+
+}
+
+#endif
@@ -13,37 +13,113 @@
 #include "Narrowing.h"
 #include "OffsetPointer.h"
 #include "Address.h"
-#include "RAOffset.h"
+// llvm includes
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/ErrorHandling.h"
+// libc includes
+#include <algorithm>
+#include <cassert>
+#include <string>
 
 using namespace llvm;
 
-//Functions someone should alter to add a new offset representation
+/// Commmand line options
+static cl::list<std::string> OffsetNames("obaa-offsets",
+  cl::desc("Offset representations used by obaa (default: const)"),
+  cl::CommaSeparated);
+
+//Offset representation registry
 //===--------------------------------------------------------------------===//
-/// \brief Add custom offset representation initialization
-void initialization(OffsetBasedAliasAnalysis* Analysis) {
+
+/// \brief Storage of the registered representations, kept in a function so
+/// registration does not depend on static initialization order
+static std::vector<OffsetRepresentationInfo>& getRegistered() {
+  static std::vector<OffsetRepresentationInfo> registered;
+  return registered;
+}
+
+/// \brief Adds a representation to the registry
+void OffsetRepresentationRegistry::add(const OffsetRepresentationInfo& Info) {
+  getRegistered().push_back(Info);
+}
+
+/// \brief Returns all registered representations
+const std::vector<OffsetRepresentationInfo>& 
+OffsetRepresentationRegistry::registered() {
+  return getRegistered();
+}
+
+/// \brief Returns the representations selected with -obaa-offsets, or the
+/// default ones if the option is not given, ordered by cost.
+const std::vector<const OffsetRepresentationInfo*>&
+OffsetRepresentationRegistry::active() {
+  static std::vector<const OffsetRepresentationInfo*> active;
+  static bool selected = false;
+  if(selected) return active;
+  selected = true;
   
+  const std::vector<OffsetRepresentationInfo>& reg = getRegistered();
+  if(OffsetNames.empty()) {
+    for(auto& i : reg) 
+      if(i.Default) active.push_back(&i);
+  } else {
+    for(auto& name : OffsetNames) {
+      const OffsetRepresentationInfo* found = NULL;
+      for(auto& i : reg)
+        if(name == i.Name) found = &i;
+      if(found == NULL)
+        report_fatal_error("obaa: unknown offset representation '" + name
+          + "'");
+      if(std::find(active.begin(), active.end(), found) == active.end())
+        active.push_back(found);
+    }
+  }
+  
+  std::stable_sort(active.begin(), active.end(), 
+    [](const OffsetRepresentationInfo* A, const OffsetRepresentationInfo* B) {
+      return A->Cost < B->Cost; 
+    });
+  
+  DEBUG_WITH_TYPE("phases", errs() << "Offset representations:");
+  for(auto i : active)
+    DEBUG_WITH_TYPE("phases", errs() << " " << i->Name << "(" << i->Cost 
+      << ")");
+  DEBUG_WITH_TYPE("phases", errs() << "\n");
+  return active;
+}
+
+//Functions that dispatch to the active offset representations
+//===--------------------------------------------------------------------===//
+
+/// \brief Initializes the active offset representations
+void Offset::initialization(OffsetBasedAliasAnalysis* Analysis) {
+  for(auto i : OffsetRepresentationRegistry::active())
+    i->initialization(Analysis);
 }
   
-/// \brief Add custom offset representation to reps for use in obaa.
-/// This constructor should return a neutral offset element
+/// \brief Creates a neutral offset element in every active representation.
+/// Representations are keyed by their position in the active list, so
+/// cheaper representations are visited first.
 Offset::Offset() {
-  // reps[ID] = new YourOffsetRepresentation();
-
-  reps[0] = new RAOffset();
+  const std::vector<const OffsetRepresentationInfo*>& active = 
+    OffsetRepresentationRegistry::active();
+  for(unsigned i = 0; i < active.size(); i++)
+    reps[i] = active[i]->createNeutral();
 }
   
 /// \brief Creates the offset occording to \p a = \p b + offset
 Offset::Offset(const Value* A, const Value* B) {
-  // reps[ID] = new YourOffsetRepresentation(A, B);
-
-  reps[0] = new RAOffset(A, B);
+  const std::vector<const OffsetRepresentationInfo*>& active = 
+    OffsetRepresentationRegistry::active();
+  for(unsigned i = 0; i < active.size(); i++)
+    reps[i] = active[i]->create(A, B);
 }
   
-/// \brief Add custom offset representation required analyses
+/// \brief Adds the analyses required by the active representations
 void Offset::getAnalysisUsage(AnalysisUsage &AU) {
-  // AU.addRequired<RequiredAnalysis>();
-
-  AU.addRequired<IntraProceduralRA<Cousot> >();
+  for(auto i : OffsetRepresentationRegistry::active())
+    i->getAnalysisUsage(AU);
 }
   
 //Functions that should be left alone on creating new offset representation
@@ -53,6 +129,7 @@ void Offset::getAnalysisUsage(AnalysisUsage &AU) {
 Offset::Offset(const Offset& Other) {
   for (auto i : Other.reps) {
     reps[i.first] = i.second->copy();
+    assert(reps[i.first] != NULL and "offset representation lost a copy");
   }
 }
 
@@ -66,6 +143,7 @@ Offset& Offset::operator=(const Offset& Other) {
   for (auto i : reps) delete i.second;
   for (auto i : Other.reps) {
     reps[i.first] = i.second->copy();
+    assert(reps[i.first] != NULL and "offset representation lost a copy");
   }
   return *this;
 }
@@ -73,19 +151,24 @@ Offset& Offset::operator=(const Offset& Other) {
 /// \brief Adds two offsets
 Offset Offset::operator+(const Offset& Other) const {
   Offset result;
-  for (auto i : result.reps) {
+  for (auto& i : result.reps) {
     const int ID = i.first;
-    result.reps[ID] = reps.at(ID)->add(Other.reps.at(ID));
+    delete i.second;
+    i.second = reps.at(ID)->add(Other.reps.at(ID));
+    assert(i.second != NULL and "offset representation lost a sum");
   }
   return result;
   
 }
 
-/// \brief Answers true if two offsets are disjoints
-bool Offset::operator!=(const Offset& Other) const {
+/// \brief Answers true if an access of \p Size bytes at this offset and 
+/// one of \p OtherSize bytes at \p Other cannot overlap
+bool Offset::disjoint(const Offset& Other, uint64_t Size, 
+uint64_t OtherSize) const {
   for (auto i : reps) {
     const int ID = i.first;
-    if(reps.at(ID)->disjoint(Other.reps.at(ID))) return true;
+    if(reps.at(ID)->disjoint(Other.reps.at(ID), Size, OtherSize)) 
+      return true;
   }
   return false;
 }
@@ -95,10 +178,15 @@ void Offset::narrow(const NarrowingOp& Narrowing_op, OffsetPointer* Base) {
   for(auto ad : Narrowing_op.cmp_v->addresses) {
     if(ad->getBase() == Base) {
       Offset narrowing_offset = ad->getOffset() + Narrowing_op.context;
-      for (auto i : reps) {
+      for (auto& i : reps) {
         const int ID = i.first;
-        reps[ID] = i.second->narrow(Narrowing_op.cmp_op, 
+        OffsetRepresentation* narrowed = i.second->narrow(Narrowing_op.cmp_op,
           narrowing_offset.reps.at(ID));
+        assert(narrowed != NULL and "offset representation lost a narrowing");
+        if(narrowed != i.second) {
+          delete i.second;
+          i.second = narrowed;
+        }
       }   
     }
   }
@@ -106,11 +194,40 @@ void Offset::narrow(const NarrowingOp& Narrowing_op, OffsetPointer* Base) {
 
 /// \brief Widens the offset
 void Offset::widen(const WideningOp& Widening_op) { 
-  for (auto i : reps) {
+  for (auto& i : reps) {
     const int ID = i.first;
-    reps[ID] = i.second->widen(Widening_op.before.reps.at(ID), 
-      Widening_op.after.reps.at(ID));
+    OffsetRepresentation* widened = i.second->widen(
+      Widening_op.before.reps.at(ID), Widening_op.after.reps.at(ID));
+    assert(widened != NULL and "offset representation lost a widening");
+    if(widened != i.second) {
+      delete i.second;
+      i.second = widened;
+    }
+  }
+}
+
+/// \brief Gives the tightest byte bounds known by the representations,
+/// INT64_MIN and INT64_MAX when unbounded
+void Offset::getBounds(int64_t& Lo, int64_t& Hi) const {
+  Lo = INT64_MIN;
+  Hi = INT64_MAX;
+  for (auto i : reps) {
+    int64_t lo, hi;
+    if(i.second->getBounds(lo, hi)) {
+      Lo = std::max(Lo, lo);
+      Hi = std::min(Hi, hi);
+    }
   }
+  //contradicting representations happen only on unreachable code
+  if(Lo > Hi) {
+    Lo = INT64_MIN;
+    Hi = INT64_MAX;
+  }
+}
+
+/// \brief Restricts the offset to the byte interval [Lo, Hi]
+void Offset::clamp(int64_t Lo, int64_t Hi) {
+  for (auto i : reps) i.second->clamp(Lo, Hi);
 }
 
 /// \brief Prints the offset
@@ -13,6 +13,9 @@
 /// representation and requires simple operations: Adding two offsets, 
 /// checking if two offsets are disjoint, narrow an offset and widen it. 
 /// 
+/// Offset representations register themselves with
+/// RegisterOffsetRepresentation, and the ones used by obaa are chosen at
+/// runtime with -obaa-offsets=name1,name2,...
 ///
 //===----------------------------------------------------------------------===//
 
@@ -23,7 +26,9 @@
 #include "llvm/IR/InstrTypes.h"
 #include "llvm/Support/raw_ostream.h"
 // libc includes
+#include <cstdint>
 #include <map>
+#include <vector>
 
 namespace llvm {
 
@@ -54,8 +59,11 @@ public:
   /// \brief Adds two offsets of the respective representation
   virtual OffsetRepresentation* add(OffsetRepresentation* Other) =0;
   
-  /// \brief Answers true if two offsets are disjoints
-  virtual bool disjoint(OffsetRepresentation* Other) =0;
+  /// \brief Answers true if an access of \p Size bytes at this offset and 
+  ///   one of \p OtherSize bytes at \p Other cannot overlap. Sizes may be
+  ///   MemoryLocation::UnknownSize.
+  virtual bool disjoint(OffsetRepresentation* Other, uint64_t Size, 
+    uint64_t OtherSize) =0;
   
   /// \brief Narrows the offset of the respective representation
   virtual OffsetRepresentation* narrow(CmpInst::Predicate Cmp, 
@@ -66,11 +74,81 @@ public:
   virtual OffsetRepresentation* widen(OffsetRepresentation* Before,
     OffsetRepresentation* After) =0;
   
+  /// \brief Gives byte bounds of the offset, if the representation knows
+  /// them
+  virtual bool getBounds(int64_t& Lo, int64_t& Hi) { return false; }
+  
+  /// \brief Restricts the offset to the byte interval [Lo, Hi], if the
+  /// representation is able to
+  virtual void clamp(int64_t Lo, int64_t Hi) { }
+  
   /// \brief Prints the offset representation
   virtual void print() { }
   /// \brief Prints the offset to a file
   virtual void print(raw_fd_ostream& fs) { }
   
+  /// \brief Adds the analyses this representation requires. Hidden by
+  /// representations that need any.
+  static void getAnalysisUsage(AnalysisUsage &AU) { }
+  
+  /// \brief Fetches the analyses this representation requires. Hidden by
+  /// representations that need any.
+  static void initialization(OffsetBasedAliasAnalysis* Analysis) { }
+  
+};
+
+/// \brief Description of an offset representation that can be selected
+/// with -obaa-offsets.
+struct OffsetRepresentationInfo {
+  const char* Name;
+  const char* Description;
+  /// \brief Relative cost of keeping the representation. Cheaper
+  /// representations are queried first for disjointness.
+  unsigned Cost;
+  /// \brief Whether the representation is active when -obaa-offsets is
+  /// not given
+  bool Default;
+  OffsetRepresentation* (*createNeutral)();
+  OffsetRepresentation* (*create)(const Value* Pointer, const Value* Base);
+  void (*getAnalysisUsage)(AnalysisUsage &AU);
+  void (*initialization)(OffsetBasedAliasAnalysis* Analysis);
+};
+
+/// \brief Holds every registered offset representation and the ones
+/// selected for the current run.
+class OffsetRepresentationRegistry {
+
+public:
+  /// \brief Adds a representation to the registry
+  static void add(const OffsetRepresentationInfo& Info);
+  
+  /// \brief Returns all registered representations
+  static const std::vector<OffsetRepresentationInfo>& registered();
+  
+  /// \brief Returns the representations selected with -obaa-offsets, or the
+  /// default ones if the option is not given, ordered by cost.
+  static const std::vector<const OffsetRepresentationInfo*>& active();
+};
+
+/// \brief Registers an offset representation. \p Rep must provide a neutral
+/// constructor, a (Pointer, Base) constructor and the static functions
+/// getAnalysisUsage and initialization. Representations that are not 
+/// \p Default are only used when -obaa-offsets names them.
+/// Use it as: static RegisterOffsetRepresentation<YourRep> X("name", "desc", 1);
+template <class Rep>
+struct RegisterOffsetRepresentation {
+  RegisterOffsetRepresentation(const char* Name, const char* Description,
+  unsigned Cost, bool Default = true) {
+    OffsetRepresentationInfo Info = { Name, Description, Cost, Default,
+      &createNeutral, &create, &Rep::getAnalysisUsage, &Rep::initialization };
+    OffsetRepresentationRegistry::add(Info);
+  }
+  
+  static OffsetRepresentation* createNeutral() { return new Rep(); }
+  
+  static OffsetRepresentation* create(const Value* Pointer, const Value* Base){
+    return new Rep(Pointer, Base);
+  }
 };
 
 /// \brief Class that encapsulates the concept of a pointer's offset.
@@ -81,17 +159,16 @@ class Offset{
 
 public:
 
-  /// \brief Add custom offset representation initialization
+  /// \brief Initializes the active offset representations
   static void initialization(OffsetBasedAliasAnalysis* Analysis);
 
-  /// \brief Add custom offset representation to reps for use in obaa.
-  /// This constructor should return a neutral offset element
+  /// \brief Creates a neutral offset element in every active representation
   Offset();
   
   /// \brief Creates the offset occording to \p a = \p b + offset
   Offset(const Value* A, const Value* B);
   
-  /// \brief Add custom offset representation required analyses
+  /// \brief Adds the analyses required by the active representations
   static void getAnalysisUsage(AnalysisUsage &AU);
   
   /// \brief Copy contructor 
@@ -106,8 +183,10 @@ public:
   /// \brief Adds two offsets
   Offset operator+(const Offset& Other) const;
   
-  /// \brief Answers true if two offsets are disjoints
-  bool operator!=(const Offset& Other) const;
+  /// \brief Answers true if an access of \p Size bytes at this offset and 
+  /// one of \p OtherSize bytes at \p Other cannot overlap
+  bool disjoint(const Offset& Other, uint64_t Size, uint64_t OtherSize) 
+    const;
   
   /// \brief Narrows the offset, Base is nacessary since you only use addresses
   /// with the same base for the narrowing process. 
@@ -116,6 +195,13 @@ public:
   /// \brief Widens the offset
   void widen(const WideningOp& Widening_op);
   
+  /// \brief Gives the tightest byte bounds known by the representations,
+  /// INT64_MIN and INT64_MAX when unbounded
+  void getBounds(int64_t& Lo, int64_t& Hi) const;
+  
+  /// \brief Restricts the offset to the byte interval [Lo, Hi]
+  void clamp(int64_t Lo, int64_t Hi);
+  
   /// \brief Prints the offset
   void print() const;
   /// \brief Prints the offset to a file
@@ -14,15 +14,32 @@
 // local includes
 #include "OffsetBasedAliasAnalysis.h"
 #include "Address.h"
+#include "AddressTriples.h"
+#include "DifferenceBounds.h"
 #include "Narrowing.h"
 #include "Offset.h"
 #include "OffsetPointer.h"
+#include "RAOffset.h"
 // llvm includes
+#include "llvm/ADT/IntEqClasses.h"
 #include "llvm/ADT/Statistic.h"
+#include "llvm/ADT/SCCIterator.h"
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/Analysis/AliasAnalysis.h"
+#include "llvm/Analysis/CallGraph.h"
+#include "llvm/Analysis/CaptureTracking.h"
+#include "llvm/Analysis/MemoryBuiltins.h"
+#include "llvm/Analysis/TargetLibraryInfo.h"
 #include "llvm/IR/Argument.h"
+#include "llvm/IR/CallSite.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/DataLayout.h"
+#include "llvm/IR/DerivedTypes.h"
+#include "llvm/IR/GetElementPtrTypeIterator.h"
 #include "llvm/IR/GlobalVariable.h"
+#include "llvm/IR/InlineAsm.h"
 #include "llvm/IR/InstIterator.h"
+#include "llvm/IR/IntrinsicInst.h"
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/InstrTypes.h"
 #include "llvm/IR/Module.h"
@@ -33,16 +50,44 @@
 #include "llvm/Support/Casting.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/raw_ostream.h"
 // STL includes
 #include <set>
 #include <string>
 #include <map>
+#include <algorithm>
 #include <cassert>
+#include <atomic>
+#include <chrono>
 
 STATISTIC(NumPointers, "Number of pointers from the module");
 STATISTIC(NumRelevantStores, "Number of relevant stores from the module");
 STATISTIC(NumUnkPointers, "Number of unknown pointers");
+STATISTIC(NumAliasQueries, "Number of alias queries");
+STATISTIC(NumAliasFallbacks, "Number of alias queries passed to the next AA");
+STATISTIC(NumNoAliasClass, "Number of NoAlias answers from alias classes");
+STATISTIC(NumNoAliasSignature, "Number of NoAlias answers from signatures");
+STATISTIC(NumNoAliasZones, "Number of NoAlias answers from difference bounds");
+STATISTIC(NumNoAliasLocalTree, "Number of NoAlias answers from local trees");
+STATISTIC(NumExactAnswers, "Number of answers from exact offsets");
+STATISTIC(NumNoAliasTriples, "Number of NoAlias answers from address triples");
+STATISTIC(NumNoAliasArgument, "Number of NoAlias answers using the argument "
+  "rule");
+STATISTIC(NumNoAliasBases, "Number of NoAlias answers using the different "
+  "bases rule");
+STATISTIC(NumNoAliasOffsets, "Number of NoAlias answers using the disjoint "
+  "offsets rule");
+STATISTIC(NumNoAliasAllocSize, "Number of NoAlias answers using allocation "
+  "sizes");
+STATISTIC(NumNoAliasEscape, "Number of NoAlias answers using objects that "
+  "do not escape");
+STATISTIC(NumAddressPairs, "Number of address pairs examined by queries");
+STATISTIC(NumContextClones, "Number of callee summaries instantiated");
+STATISTIC(NumHeapClones, "Number of heap objects cloned per calling context");
+STATISTIC(NumModeledLoads, "Number of loads given the stored pointers");
+STATISTIC(NumTrackedObjects, "Number of objects whose memory is followed");
+STATISTIC(NumLocalObjects, "Number of objects that do not escape");
 
 using namespace llvm;
 
@@ -51,6 +96,156 @@ static cl::opt<bool> Interprocedural("inter",
   cl::desc("Indicates obaa to run an interprocedural analysis"),
   cl::init(false));
 
+static cl::opt<bool> DifferenceBoundsEnabled("obaa-zones",
+  cl::desc("Keeps difference constraints between pointers of a function"),
+  cl::init(true));
+
+static cl::opt<bool> AliasClasses("obaa-alias-classes",
+  cl::desc("Partitions pointers into may alias classes after solving"),
+  cl::init(false));
+
+static cl::opt<unsigned> DifferenceBoundsMaxVars("obaa-zone-max-vars",
+  cl::desc("Maximum number of pointers related by difference constraints"),
+  cl::init(64));
+
+static cl::opt<unsigned> MemoryRounds("obaa-memory-rounds",
+  cl::desc("Rounds of store to load modelling, 0 disables it"),
+  cl::init(2));
+
+static cl::opt<bool> EscapeAnalysis("obaa-escape",
+  cl::desc("Applies the argument rule only to objects that do not escape, "
+    "which are also disjoint from unknown pointers"),
+  cl::init(true));
+
+static cl::opt<unsigned> ContextDepth("obaa-context-depth",
+  cl::desc("Length of the call strings whose callee summaries are "
+    "instantiated at call sites in -inter mode, 0 disables it"),
+  cl::init(0));
+
+static cl::opt<bool> HeapCloning("obaa-heap-cloning",
+  cl::desc("Gives the heap objects returned by instantiated callees a base "
+    "per calling context, needs -obaa-context-depth > 0. Only callees that "
+    "do not always return fresh allocations gain from it, the calls to the "
+    "others are already a base each"),
+  cl::init(false));
+
+static cl::opt<unsigned> ContextMaxSize("obaa-context-max-size",
+  cl::desc("Maximum number of instructions of an instantiated function"),
+  cl::init(64));
+
+static cl::opt<unsigned> ContextBudget("obaa-context-budget",
+  cl::desc("Maximum number of callee summaries instantiated in the module"),
+  cl::init(4096));
+
+static cl::opt<bool> QueryTiming("obaa-query-timing",
+  cl::desc("Keeps a latency histogram of the alias queries"),
+  cl::init(false));
+
+static cl::opt<std::string> QueryStatsJSON("obaa-stats-json",
+  cl::desc("Writes the alias query counters and latencies as JSON"),
+  cl::value_desc("filename"), cl::init(""));
+
+/// Query instrumentation
+namespace {
+/// \brief Counters of the alias queries. They mirror the statistics above
+/// so the JSON report does not depend on LLVM being built with statistics.
+enum QueryCounter {
+  QC_Queries, QC_Fallbacks, QC_Class, QC_Signature, QC_Zones, QC_LocalTree,
+  QC_Exact, QC_Triples, QC_Argument, QC_Bases, QC_Offsets, QC_AllocSize,
+  QC_Escape, QC_AddressPairs, QC_Num
+};
+const char* const QueryCounterNames[QC_Num] = {
+  "queries", "fallbacks", "noalias_class", "noalias_signature",
+  "noalias_zones", "noalias_local_tree", "exact", "noalias_triples",
+  "noalias_argument", "noalias_bases", "noalias_offsets",
+  "noalias_alloc_size", "noalias_escape", "address_pairs"
+};
+Statistic* const QueryStatistics[QC_Num] = {
+  &NumAliasQueries, &NumAliasFallbacks, &NumNoAliasClass, 
+  &NumNoAliasSignature, &NumNoAliasZones, &NumNoAliasLocalTree, 
+  &NumExactAnswers, &NumNoAliasTriples, &NumNoAliasArgument, 
+  &NumNoAliasBases, &NumNoAliasOffsets, &NumNoAliasAllocSize, 
+  &NumNoAliasEscape, &NumAddressPairs
+};
+std::atomic<uint64_t> QueryCounts[QC_Num];
+/// \brief Latency histogram, bucket i counts the queries that took less
+/// than 2^i nanoseconds
+const unsigned NumLatencyBuckets = 32;
+std::atomic<uint64_t> QueryLatencies[NumLatencyBuckets];
+}
+
+static void countQuery(QueryCounter C, uint64_t N = 1) {
+  QueryCounts[C] += N;
+  *QueryStatistics[C] += (unsigned) N;
+}
+
+static void countLatency(std::chrono::steady_clock::time_point Start) {
+  uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now() - Start).count();
+  unsigned bucket = 0;
+  while(bucket + 1 < NumLatencyBuckets and (UINT64_C(1) << bucket) <= ns)
+    bucket++;
+  QueryLatencies[bucket]++;
+}
+
+/// \brief Prints the latency histogram, one line per non empty bucket
+static void printLatencies(raw_ostream &OS) {
+  OS << "obaa alias query latencies:\n";
+  for(unsigned i = 0; i < NumLatencyBuckets; i++)
+    if(QueryLatencies[i] != 0)
+      OS << "  < 2^" << i << " ns: " << QueryLatencies[i] << "\n";
+}
+
+/// \brief Writes the query counters and the latency histogram to \p File
+static void writeQueryStatsJSON(StringRef File) {
+  std::error_code EC;
+  raw_fd_ostream OS(File, EC, sys::fs::F_Text);
+  if(EC) {
+    errs() << "obaa: cannot write " << File << ": " << EC.message() << "\n";
+    return;
+  }
+  OS << "{\n";
+  for(unsigned i = 0; i < QC_Num; i++)
+    OS << "  \"" << QueryCounterNames[i] << "\": " << QueryCounts[i] << ",\n";
+  uint64_t queries = QueryCounts[QC_Queries];
+  OS << "  \"avg_address_pairs\": " 
+    << (queries ? (double) QueryCounts[QC_AddressPairs] / queries : 0.0) 
+    << ",\n";
+  OS << "  \"latency_ns_log2\": [";
+  for(unsigned i = 0; i < NumLatencyBuckets; i++)
+    OS << (i ? ", " : "") << QueryLatencies[i];
+  OS << "]\n}\n";
+}
+
+/// \brief Answers whether \p P is an argument that may point to the
+/// caller's memory, unique arguments are allocs instead
+static bool isSharedArgument(const OffsetPointer* P) {
+  return isa<const Argument>(P->getPointer()) 
+    and P->getPointerType() != OffsetPointer::Alloc;
+}
+
+/// \brief Answers whether \p Base is an object arguments cannot point to:
+/// an alloc that does not escape, or any known base without -obaa-escape
+static bool isLocalBase(const OffsetPointer* Base) {
+  if(!EscapeAnalysis) return Base->getPointerType() != OffsetPointer::Unk;
+  return Base->getPointerType() == OffsetPointer::Alloc 
+    and !Base->mayEscape();
+}
+
+/// \brief The bases a pointer stands for after intra procedural solving,
+/// itself if it is a base
+static void getBases(OffsetPointer* P, std::vector<OffsetPointer*> &Bases,
+std::vector<Offset> &Offsets) {
+  if(P->addr_empty()) {
+    Bases.push_back(P);
+    Offsets.push_back(Offset());
+  }
+  for(auto a = P->addr_begin(), e = P->addr_end(); a != e; a++) {
+    Bases.push_back((*a)->getBase());
+    Offsets.push_back((*a)->getOffset());
+  }
+}
+
 /// LLVM framework methods and atributes
 char OffsetBasedAliasAnalysis::ID = 0;
 
@@ -59,8 +254,17 @@ static RegisterPass<OffsetBasedAliasAnalysis> X("obaa",
 
 static RegisterAnalysisGroup<AliasAnalysis> E(X);
 
+OffsetBasedAliasAnalysis::~OffsetBasedAliasAnalysis() {
+  if(QueryTiming and AreStatisticsEnabled())
+    printLatencies(errs());
+  if(!QueryStatsJSON.empty())
+    writeQueryStatsJSON(QueryStatsJSON);
+}
+
 void OffsetBasedAliasAnalysis::getAnalysisUsage(AnalysisUsage &AU) const {
   AliasAnalysis::getAnalysisUsage(AU);
+  AU.addRequired<CallGraphWrapperPass>();
+  AU.addRequired<TargetLibraryInfoWrapperPass>();
   Offset::getAnalysisUsage(AU);
   AU.setPreservesAll();
 }
@@ -87,13 +291,19 @@ bool OffsetBasedAliasAnalysis::runOnModule(Module &M) {
   DEBUG_WITH_TYPE("phases", errs() << "Getting narrowing information\n");
   getNarrowingInfo();
   
+  /// Relational constraints between pointers of the same function
+  if(DifferenceBoundsEnabled) {
+    DEBUG_WITH_TYPE("phases", errs() << "Building difference bounds\n");
+    buildDifferenceBounds(M);
+  }
+  
   DEBUG_WITH_TYPE("dot_graphs", printDOT(M, std::string("_pre_analysis")));
   
   /// Local trees capture
   DEBUG_WITH_TYPE("phases", errs() << "Capturing local trees\n");
-  for(auto i : offset_pointers) {
-    i.second->getPathToRoot();
-  }
+  std::vector<OffsetPointer*> pointers;
+  for(auto i : offset_pointers) pointers.push_back(i.second);
+  local_trees.build(pointers);
   
   /// Intraprocedural analysis
   /// Normalizing all ranged pointers so they only have non
@@ -108,13 +318,23 @@ bool OffsetBasedAliasAnalysis::runOnModule(Module &M) {
   resolveWholeGraph();
 
   /// Constext sensitive part that updates the call insts
+  DEBUG_WITH_TYPE("phases", errs() << "Finding allocation functions\n");
+  analyzeCallGraph();
+  
   DEBUG_WITH_TYPE("phases", errs() << "Updating calls to allocs\n");
   updateCalls();
 
+  /// Pointers stored to memory and loaded back
+  DEBUG_WITH_TYPE("phases", errs() << "Modelling memory\n");
+  modelMemory();
+
   DEBUG_WITH_TYPE("dot_graphs", printDOT(M, std::string("_post_intra")));
 
   /// Interprocedural analysis
   if(Interprocedural) {
+    DEBUG_WITH_TYPE("phases", errs() << "Resolving indirect calls\n");
+    resolveIndirectCalls();
+
     DEBUG_WITH_TYPE("phases", errs() << "Adding interprocedural edges\n");
     addInterProceduralEdges();
 
@@ -132,6 +352,9 @@ bool OffsetBasedAliasAnalysis::runOnModule(Module &M) {
     DEBUG_WITH_TYPE("dot_graphs", printDOT(M, std::string("_post_inter")));
   }
 
+  /// Reallocated objects keep their base but not their size
+  dropReallocatedSizes();
+
   /// Applying narrowing and widening operators
   applyWidening();
   applyNarrowing();
@@ -148,6 +371,26 @@ bool OffsetBasedAliasAnalysis::runOnModule(Module &M) {
         i.second->setPointerType(OffsetPointer::Unk);
     }
 
+  /// Objects that pointers outside the graph cannot reach
+  if(EscapeAnalysis) {
+    DEBUG_WITH_TYPE("phases", errs() << "Finding escaping objects\n");
+    findEscapingObjects();
+  }
+
+  DEBUG_WITH_TYPE("phases", errs() << "Building address triples\n");
+  buildAddressTriples();
+
+  DEBUG_WITH_TYPE("phases", errs() << "Summarizing functions' accesses\n");
+  buildModRefSummaries(M);
+
+  if(AliasClasses) {
+    DEBUG_WITH_TYPE("phases", errs() << "Building alias classes\n");
+    buildAliasClasses();
+  }
+
+  DEBUG_WITH_TYPE("phases", errs() << "Freezing the graph for queries\n");
+  freeze();
+
   DEBUG_WITH_TYPE("phases", errs() << "Control flow reached the end.\n");
 
   DEBUG_WITH_TYPE("dot_graphs", printDOT(M, std::string("_finished")));
@@ -158,106 +401,508 @@ bool OffsetBasedAliasAnalysis::runOnModule(Module &M) {
   return false;
 }
 
+/// \brief Answers true if \p A cannot address an access of \p Size bytes
+/// starting at its offset, or if an access of \p OtherSize bytes cannot
+/// fit in \p A's object, using the size of \p A's allocation.
+static bool outsideAllocation(const Address* A, uint64_t Size, 
+uint64_t OtherSize) {
+  OffsetPointer* base = A->getBase();
+  if(!base->hasAllocSize()) return false;
+  int64_t alloc_size = base->getAllocSizeUpper();
+  
+  //the other access is larger than the whole object
+  if(OtherSize != MemoryLocation::UnknownSize 
+  and OtherSize > (uint64_t) alloc_size)
+    return true;
+  
+  //the offset runs outside the object
+  int64_t lo, hi;
+  A->getOffset().getBounds(lo, hi);
+  if(hi < 0 or lo >= alloc_size) return true;
+  if(Size != MemoryLocation::UnknownSize and lo >= 0 
+  and Size > (uint64_t) (alloc_size - lo))
+    return true;
+  return false;
+}
+
+/// \brief Compares two pointers of the same local tree by their offsets 
+/// \p A and \p B from a common ancestor, which is a single value, so they
+/// point into the same object. Returns MustAlias if the accesses start at
+/// the same byte and have the same size, PartialAlias if they overlap 
+/// otherwise, NoAlias if they are apart and MayAlias if an offset is not
+/// constant or a size is unknown.
+static AliasResult exactAlias(const Offset& A, uint64_t SizeA,
+const Offset& B, uint64_t SizeB) {
+  if(SizeA == MemoryLocation::UnknownSize 
+  or SizeB == MemoryLocation::UnknownSize)
+    return MayAlias;
+  
+  int64_t lo_a, hi_a, lo_b, hi_b;
+  A.getBounds(lo_a, hi_a);
+  B.getBounds(lo_b, hi_b);
+  if(lo_a != hi_a or lo_b != hi_b)
+    return MayAlias;
+  
+  if(lo_a == lo_b and SizeA == SizeB)
+    return MustAlias;
+  if(SizeA == 0 or SizeB == 0)
+    return NoAlias;
+  
+  //[lo_a, lo_a + SizeA) and [lo_b, lo_b + SizeB) intersect
+  if(lo_a <= lo_b) {
+    if((uint64_t) (lo_b - lo_a) < SizeA) return PartialAlias;
+  } else {
+    if((uint64_t) (lo_a - lo_b) < SizeB) return PartialAlias;
+  }
+  return NoAlias;
+}
+
 /// Alias Analysis framework methods
 AliasResult OffsetBasedAliasAnalysis::alias(const MemoryLocation &LocA, 
 const MemoryLocation &LocB) {
-  OffsetPointer* op1 = getOffsetPointer(LocA.Ptr);
-  OffsetPointer* op2 = getOffsetPointer(LocB.Ptr);
+  std::chrono::steady_clock::time_point start;
+  if(QueryTiming) start = std::chrono::steady_clock::now();
+  countQuery(QC_Queries);
+
+  OffsetPointer* op1 = findOffsetPointer(LocA.Ptr);
+  OffsetPointer* op2 = findOffsetPointer(LocB.Ptr);
 
   // If one of these pointers is not in the graph pass it to the next analysis
   // int the chain
-  if (op1 == NULL or op2 == NULL)
-    return AliasAnalysis::alias(LocA, LocB);
+  AliasResult result;
+  if (op1 == NULL or op2 == NULL) {
+    countQuery(QC_Fallbacks);
+    result = AliasAnalysis::alias(LocA, LocB);
+  }
+  else
+    result = aliasPointers(op1, LocA, op2, LocB);
 
-  // Local tree verification
+  if(QueryTiming) countLatency(start);
+  return result;
+}
 
-  if(op1->local_root == op2->local_root) {
-    int index = -1;
-    OffsetPointer* ancestor = NULL;
-    for(auto i : op1->path_to_root) {
-      if(index > -1 and i.second.first > index) {
-        continue;
-      }
-      else if(op2->path_to_root.count(i.first)) {  
-        if(index == -1 or i.second.first < index) {
-         index = i.second.first;
-         ancestor = i.first;
-        }
-      } 
-    }
+/// \brief Answers the alias query once both offset pointers are known
+AliasResult OffsetBasedAliasAnalysis::aliasPointers(OffsetPointer* op1,
+const MemoryLocation &LocA, OffsetPointer* op2, const MemoryLocation &LocB) {
+  // Class verification, pointers of different classes share no base
+  if(op1->alias_class >= 0 and op2->alias_class >= 0
+  and op1->alias_class != op2->alias_class) {
+    countQuery(QC_Class);
+    return NoAlias;
+  }
+
+  // Signature verification, pointers without unknown bases whose bases'
+  // signatures do not intersect share no base
+  if(op1->unk_signature == 0 and op2->unk_signature == 0
+  and (op1->base_signature & op2->base_signature) == 0) {
+    countQuery(QC_Signature);
+    return NoAlias;
+  }
 
-    if(op1->path_to_root[ancestor].second
-    != op1->path_to_root[ancestor].second) {
+  // Relational verification, the pointers bound each other
+  if(difference_bounds != NULL and difference_bounds->disjoint(LocA.Ptr,
+  LocA.Size, LocB.Ptr, LocB.Size)) {
+    countQuery(QC_Zones);
+    return NoAlias;
+  }
+
+  // Local tree verification, both pointers are their lowest common ancestor
+  // plus the offsets along their paths, and the accessed bytes are apart
+  OffsetPointer* ancestor = local_trees.lca(op1, op2);
+  if(ancestor != NULL) {
+    int64_t lo, hi;
+    ancestor->local_offset.getBounds(lo, hi);
+    //the path shared above the ancestor adds the same amount to both
+    // offsets from the root, so comparing them is enough
+    bool from_root = ancestor->local_parent == NULL or lo == hi;
+    Offset offset1 = from_root ? op1->local_offset 
+      : local_trees.pathOffset(op1, ancestor);
+    Offset offset2 = from_root ? op2->local_offset 
+      : local_trees.pathOffset(op2, ancestor);
+    if(offset1.disjoint(offset2, LocA.Size, LocB.Size)) {
+      countQuery(QC_LocalTree);
       return NoAlias;
     }
+    
+    // Exact verification, the common ancestor is a single value, so
+    // constant offsets from it tell how the accesses overlap
+    AliasResult exact = exactAlias(offset1, LocA.Size, offset2, LocB.Size);
+    if(exact != MayAlias) {
+      countQuery(QC_Exact);
+      return exact;
+    }
   }
   
   // Dependence graph verification
 
+  // Signature fallback, with no argument involved two different unknown
+  // bases always make some address pair undecidable
+  if(!op1->arg_signature and !op2->arg_signature
+  and op1->unk_signature != 0 and op2->unk_signature != 0
+  and (op1->unk_signature != op2->unk_signature 
+    or op1->unk_signature == INT64_MIN)) {
+    countQuery(QC_Fallbacks);
+    return AliasAnalysis::alias(LocA, LocB);
+  }
+
+  // Vectorized check of all address pairs, it is enough when no pair has
+  // the same base and overlapping accessed bytes or a different unknown base
+  if(!mayOverlap(op1->triples, LocA.Size, op2->triples, LocB.Size)) {
+    countQuery(QC_Triples);
+    return NoAlias;
+  }
+
+  // Rules that proved some address pair disjoint, each one is credited
+  // when the answer is NoAlias
+  bool argument_rule = false, bases_rule = false, offsets_rule = false,
+    alloc_size_rule = false, escape_rule = false;
+  uint64_t pairs = 0;
   for(auto *i : op1->addresses) {
     for(auto *j : op2->addresses) {
-      bool disjoint = false;
-
-      //first case is a local eval, one of the pointers comes from an 
-      // argument or is an argument, the other is not unknown or global related
-      if (isa<const Argument>(op1->pointer)) {
-        if( !(isa<const Argument>(op2->pointer))
-        and op2->getPointerType() != OffsetPointer::Global
-        and !(j->argument)
-        and j->getBase()->getPointerType() != OffsetPointer::Unk
-        and !(j->global) ) {
-          disjoint = true;
-        }
-      }
-      else if (isa<const Argument>(op2->pointer)) {
-        if( op1->getPointerType() != OffsetPointer::Global
-        and !(i->argument)
-        and i->getBase()->getPointerType() != OffsetPointer::Unk
-        and !(i->global) ) {
-          disjoint = true;
-        }
-      }
-      else if (i->argument) {
-        if( op2->getPointerType() != OffsetPointer::Global
-        and !(j->argument)
-        and j->getBase()->getPointerType() != OffsetPointer::Unk
-        and !(j->global) ) {
-          disjoint = true;
-        }
-      }
-      else if (j->argument) {
-        if( op1->getPointerType() != OffsetPointer::Global
-        and i->getBase()->getPointerType() != OffsetPointer::Unk
-        and !(i->global) ) {
-          disjoint = true;
-        }
-      }
+      pairs++;
+      bool disjoint = disjointBases(op1, i, op2, j, argument_rule, 
+        escape_rule, bases_rule);
 
-      //Second case, if bases are different
-      if(i->getBase() != j->getBase()) {
-        if( i->getBase()->getPointerType() != OffsetPointer::Unk
-        and j->getBase()->getPointerType() != OffsetPointer::Unk) {
-          disjoint = true;
+      //Third case, bases are equal
+      if(i->getBase() == j->getBase()) {
+        if(i->getOffset().disjoint(j->getOffset(), LocA.Size, LocB.Size)) {
+          disjoint = offsets_rule = true;
         }
       }
-      else {
-        //Third case, bases are equal
-        if(i->getOffset() != j->getOffset()) {
-          disjoint = true;
-        }
+
+      //Fourth case, one of the accesses cannot be in the other's allocation
+      if(outsideAllocation(i, LocA.Size, LocB.Size)
+      or outsideAllocation(j, LocB.Size, LocA.Size)) {
+        disjoint = alloc_size_rule = true;
       }
 
-      if(!disjoint)
+      if(!disjoint) {
+        countQuery(QC_AddressPairs, pairs);
+        countQuery(QC_Fallbacks);
         return AliasAnalysis::alias(LocA, LocB);
+      }
     }
   }
   
+  countQuery(QC_AddressPairs, pairs);
+  if(argument_rule) countQuery(QC_Argument);
+  if(bases_rule) countQuery(QC_Bases);
+  if(offsets_rule) countQuery(QC_Offsets);
+  if(alloc_size_rule) countQuery(QC_AllocSize);
+  if(escape_rule) countQuery(QC_Escape);
   return NoAlias;
 }
 
+/// \brief Answers true if the addresses \p i of \p op1 and \p j of \p op2
+/// are on objects that are never the same, regardless of offsets. The rules
+/// that apply are set.
+bool OffsetBasedAliasAnalysis::disjointBases(const OffsetPointer* op1, 
+const Address* i, const OffsetPointer* op2, const Address* j, 
+bool &argument_rule, bool &escape_rule, bool &bases_rule) const {
+  if(i->getBase() == j->getBase()) return false;
+  bool disjoint = false;
+  
+  //first case is a local eval, one of the pointers comes from an 
+  // argument or is an argument, the other is a local object that is
+  // not global related. In -inter mode both may have the same base.
+  if (isSharedArgument(op1)) {
+    if( !isSharedArgument(op2)
+    and op2->getPointerType() != OffsetPointer::Global
+    and !(j->argument)
+    and isLocalBase(j->getBase())
+    and !(j->global) ) {
+      disjoint = argument_rule = true;
+    }
+  }
+  else if (isSharedArgument(op2)) {
+    if( op1->getPointerType() != OffsetPointer::Global
+    and !(i->argument)
+    and isLocalBase(i->getBase())
+    and !(i->global) ) {
+      disjoint = argument_rule = true;
+    }
+  }
+  else if (i->argument) {
+    if( op2->getPointerType() != OffsetPointer::Global
+    and !(j->argument)
+    and isLocalBase(j->getBase())
+    and !(j->global) ) {
+      disjoint = argument_rule = true;
+    }
+  }
+  else if (j->argument) {
+    if( op1->getPointerType() != OffsetPointer::Global
+    and isLocalBase(i->getBase())
+    and !(i->global) ) {
+      disjoint = argument_rule = true;
+    }
+  }
+  
+  //an object that does not escape is not reached by unknown pointers
+  if(EscapeAnalysis) {
+    if((i->getBase()->getPointerType() == OffsetPointer::Unk
+      and isLocalBase(j->getBase()))
+    or (j->getBase()->getPointerType() == OffsetPointer::Unk
+      and isLocalBase(i->getBase()))) {
+      disjoint = escape_rule = true;
+    }
+  }
+
+  //Second case, if bases are different
+  if( i->getBase()->getPointerType() != OffsetPointer::Unk
+  and j->getBase()->getPointerType() != OffsetPointer::Unk) {
+    disjoint = bases_rule = true;
+  }
+  
+  return disjoint;
+}
+
+/// \brief Answers true if \p op1 and \p op2 never point into the same
+/// object: they are in different alias classes, or every pair of their
+/// addresses is on different known bases or kept apart by the argument or
+/// escape rules. Offsets are not looked at, so the answer holds for every
+/// execution of both pointers, not only the ones where they are compared.
+bool OffsetBasedAliasAnalysis::disjointObjects(const OffsetPointer* op1,
+const OffsetPointer* op2) const {
+  if(op1->alias_class >= 0 and op2->alias_class >= 0
+  and op1->alias_class != op2->alias_class)
+    return true;
+  if(op1->addr_empty() or op2->addr_empty()) return false;
+  bool argument_rule, escape_rule, bases_rule;
+  for(auto *i : op1->addresses)
+    for(auto *j : op2->addresses)
+      if(!disjointBases(op1, i, op2, j, argument_rule, escape_rule, 
+      bases_rule))
+        return false;
+  return true;
+}
+
+/// \brief Computes the alias relation of all pairs of \p Locs. Locations are
+/// grouped by the bases of their addresses first, and only locations that
+/// share a base, or have an unknown one, are compared. With \p BasesOnly a
+/// pair is NoAlias only if disjointObjects proves it.
+AliasMatrix OffsetBasedAliasAnalysis::aliasMatrix(
+ArrayRef<MemoryLocation> Locs, bool BasesOnly) {
+  const unsigned n = Locs.size();
+  AliasMatrix matrix(n);
+  std::vector<OffsetPointer*> ops(n);
+  std::map<int64_t, std::vector<unsigned> > groups;
+  std::vector<unsigned> wild;
+  
+  for(unsigned i = 0; i < n; i++) {
+    matrix.setMayAlias(i, i);
+    ops[i] = findOffsetPointer(Locs[i].Ptr);
+    if(ops[i] == NULL or ops[i]->triples.size() == 0) {
+      ops[i] = NULL;
+      wild.push_back(i);
+      continue;
+    }
+    bool unknown = false;
+    for(auto b : ops[i]->triples.bases) {
+      if(b < 0) unknown = true;
+      else if(groups[b].empty() or groups[b].back() != i)
+        groups[b].push_back(i);
+    }
+    if(unknown) wild.push_back(i);
+  }
+  
+  BitVector checked(n*n);
+  auto check = [&](unsigned A, unsigned B) {
+    if(A == B) return;
+    if(A > B) std::swap(A, B);
+    if(checked.test(A*n + B)) return;
+    checked.set(A*n + B);
+    AliasResult result;
+    countQuery(QC_Queries);
+    if(BasesOnly)
+      result = ops[A] != NULL and ops[B] != NULL 
+        and disjointObjects(ops[A], ops[B]) ? NoAlias : MayAlias;
+    else if(ops[A] == NULL or ops[B] == NULL) {
+      countQuery(QC_Fallbacks);
+      result = AliasAnalysis::alias(Locs[A], Locs[B]);
+    }
+    else
+      result = aliasPointers(ops[A], Locs[A], ops[B], Locs[B]);
+    if(result != NoAlias)
+      matrix.setMayAlias(A, B);
+  };
+  
+  for(auto& g : groups)
+    for(unsigned i = 0; i < g.second.size(); i++)
+      for(unsigned j = i + 1; j < g.second.size(); j++)
+        check(g.second[i], g.second[j]);
+  for(auto w : wild)
+    for(unsigned j = 0; j < n; j++)
+      check(w, j);
+  
+  return matrix;
+}
+
+/// \brief Saturating \p A - \p B of a lower (or \p Upper) bound, where
+/// INT64_MIN and INT64_MAX stand for the infinities
+static int64_t subBounds(int64_t A, int64_t B, bool Upper) {
+  if(Upper and (A == INT64_MAX or B == INT64_MIN)) return INT64_MAX;
+  if(!Upper and (A == INT64_MIN or B == INT64_MAX)) return INT64_MIN;
+  if(B < 0 and A > INT64_MAX + B) return INT64_MAX;
+  if(B > 0 and A < INT64_MIN + B) return INT64_MIN;
+  return A - B;
+}
+
+/// \brief Bounds of \p B - \p A in bytes. The difference constraints and the
+/// offsets along the local trees are each a bound, and their intersection 
+/// is returned. A common base node is not enough, since it is an allocation
+/// site that may stand for many objects.
+OffsetDistance OffsetBasedAliasAnalysis::getOffsetDistance(const Value* A,
+const Value* B) const {
+  OffsetDistance distance = {false, INT64_MIN, INT64_MAX};
+  if(A == B) {
+    distance.Known = true;
+    distance.Min = distance.Max = 0;
+    return distance;
+  }
+  OffsetPointer* opA = findOffsetPointer(A);
+  OffsetPointer* opB = findOffsetPointer(B);
+  if(opA == NULL or opB == NULL) return distance;
+  
+  auto tighten = [&](int64_t Min, int64_t Max) {
+    distance.Min = std::max(distance.Min, Min);
+    distance.Max = std::min(distance.Max, Max);
+  };
+  
+  // Relational bounds, upper bounds of B - A and of A - B
+  if(difference_bounds != NULL) {
+    int64_t upper = difference_bounds->getBound(B, A);
+    int64_t lower = difference_bounds->getBound(A, B);
+    tighten(lower == DifferenceBounds::Inf ? INT64_MIN : -lower, upper);
+  }
+  
+  // Both pointers are their lowest common ancestor plus their paths
+  if(OffsetPointer* ancestor = local_trees.lca(opA, opB)) {
+    int64_t loA, hiA, loB, hiB;
+    local_trees.pathOffset(opA, ancestor).getBounds(loA, hiA);
+    local_trees.pathOffset(opB, ancestor).getBounds(loB, hiB);
+    tighten(subBounds(loB, hiA, false), subBounds(hiB, loA, true));
+  }
+  
+  distance.Known = distance.Min != INT64_MIN and distance.Max != INT64_MAX
+    and distance.Min <= distance.Max;
+  return distance;
+}
+
 bool OffsetBasedAliasAnalysis::pointsToConstantMemory(const MemoryLocation &Loc, 
 bool OrLocal) {
-  return AliasAnalysis::pointsToConstantMemory(Loc, OrLocal);
+  OffsetPointer* op = findOffsetPointer(Loc.Ptr);
+  if(op == NULL or op->addr_empty())
+    return AliasAnalysis::pointsToConstantMemory(Loc, OrLocal);
+
+  // Every base must be a constant global or, if local memory is accepted,
+  // an alloca whose address never escapes
+  for(auto a : op->addresses) {
+    OffsetPointer* base = a->base;
+    if(base->pointer_type == OffsetPointer::Null) continue;
+    if(base->pointer_type == OffsetPointer::Global)
+      if(const GlobalVariable* g = dyn_cast<GlobalVariable>(base->pointer))
+        if(g->isConstant()) continue;
+    if(OrLocal and base->pointer_type == OffsetPointer::Alloc)
+      if(isa<AllocaInst>(base->pointer)
+      and !PointerMayBeCaptured(base->pointer, true, true))
+        continue;
+    return AliasAnalysis::pointsToConstantMemory(Loc, OrLocal);
+  }
+  return true;
+}
+
+/// \brief Length in bytes written or read by \p MI, from its constant
+/// length or from the range of its length operand
+static uint64_t getIntrinsicLength(const MemIntrinsic* MI) {
+  const Value* length = MI->getLength();
+  if(const ConstantInt* c = dyn_cast<ConstantInt>(length))
+    return c->getZExtValue();
+  int64_t lo, hi;
+  if(RAOffset::getValueBounds(length, lo, hi) and hi >= 0 and hi < INT64_MAX)
+    return (uint64_t) hi;
+  return MemoryLocation::UnknownSize;
+}
+
+AliasAnalysis::ModRefResult OffsetBasedAliasAnalysis::getModRefInfo(
+ImmutableCallSite CS, const MemoryLocation &Loc) {
+  ModRefResult chained = AliasAnalysis::getModRefInfo(CS, Loc);
+  if(chained == NoModRef) return NoModRef;
+  
+  OffsetPointer* op = findOffsetPointer(Loc.Ptr);
+  if(op == NULL or op->addr_empty()) return chained;
+  
+  unsigned result = NoModRef;
+  // Memory intrinsics only access their pointer operands
+  if(const MemIntrinsic* mi = dyn_cast<MemIntrinsic>(CS.getInstruction())) {
+    uint64_t length = getIntrinsicLength(mi);
+    if(alias(MemoryLocation(mi->getRawDest(), length), Loc) != NoAlias)
+      result |= Mod;
+    if(const MemTransferInst* mt = dyn_cast<MemTransferInst>(mi))
+      if(alias(MemoryLocation(mt->getRawSource(), length), Loc) != NoAlias)
+        result |= Ref;
+    return ModRefResult(result & chained);
+  }
+  
+  // Calls to functions of the module use their summaries
+  const Function* callee = CS.getCalledFunction();
+  if(callee == NULL) return chained;
+  auto s = modref_summaries.find(callee);
+  if(s == modref_summaries.end()) return chained;
+  const ModRefSummary &summary = s->second;
+  if(callMayAccess(CS, summary.mod_args, summary.mod_bases, 
+  summary.mod_unknown, op))
+    result |= Mod;
+  if(callMayAccess(CS, summary.ref_args, summary.ref_bases, 
+  summary.ref_unknown, op))
+    result |= Ref;
+  return ModRefResult(result & chained);
+}
+
+/// \brief Answers whether a call \p CS whose callee accesses \p Args,
+/// \p Bases or unknown memory may access the memory of \p Loc
+bool OffsetBasedAliasAnalysis::callMayAccess(ImmutableCallSite CS, 
+const std::set<unsigned> &Args, const std::set<const OffsetPointer*> &Bases,
+bool Unknown, const OffsetPointer* Loc) {
+  if(Unknown) return true;
+  for(auto k : Args) {
+    if(k >= CS.arg_size()) return true;
+    if(mayShareBase(findOffsetPointer(CS.getArgument(k)), Loc)) return true;
+  }
+  for(auto a : Loc->addresses)
+    if(a->base->pointer_type == OffsetPointer::Unk 
+    or Bases.count(a->base->origin))
+      return true;
+  return false;
+}
+
+/// \brief Answers whether \p A and \p B may have a base in common,
+/// regardless of offsets
+bool OffsetBasedAliasAnalysis::mayShareBase(const OffsetPointer* A, 
+const OffsetPointer* B) const {
+  if(A == NULL or B == NULL or A->addr_empty() or B->addr_empty()) 
+    return true;
+  for(auto i : A->addresses)
+    for(auto j : B->addresses)
+      if(i->base->origin == j->base->origin
+      or i->base->pointer_type == OffsetPointer::Unk
+      or j->base->pointer_type == OffsetPointer::Unk)
+        return true;
+  return false;
+}
+
+/// \brief Returns the offset pointer of \p V if it is in the graph,
+/// without adding it
+OffsetPointer* OffsetBasedAliasAnalysis::findOffsetPointer(
+const Value* V) const {
+  if(frozen) {
+    auto i = query_index.find(V);
+    if(i == query_index.end()) return NULL;
+    return i->second;
+  }
+  auto i = offset_pointers.find(V);
+  if(i == offset_pointers.end()) return NULL;
+  return i->second;
 }
 
 /// \brief Function that returns the offset pointer corresponding
@@ -267,11 +912,24 @@ OffsetPointer* OffsetBasedAliasAnalysis::getOffsetPointer(const Value* V) {
   // TODO: add assertion
   if(!type->isPointerTy())
     return NULL;
+  if(frozen)
+    return findOffsetPointer(V);
   if(offset_pointers[V] == NULL)
     offset_pointers[V] = new OffsetPointer(V, OffsetPointer::Unk);
   return offset_pointers[V];
 }
 
+/// \brief Builds the query index and stops the graph from changing. After
+/// this point queries only read the graph.
+void OffsetBasedAliasAnalysis::freeze() {
+  query_index.clear();
+  query_index.reserve(offset_pointers.size());
+  for(auto p : offset_pointers)
+    if(p.second != NULL and !p.second->addr_empty())
+      query_index[p.first] = p.second;
+  frozen = true;
+}
+
 /// \brief Gather all pointers from the module
 void OffsetBasedAliasAnalysis::gatherPointers(Module &M) {
   /// Go through global variables to find arrays, structs and pointers
@@ -290,6 +948,14 @@ void OffsetBasedAliasAnalysis::gatherPointers(Module &M) {
     for (inst_iterator I = inst_begin(F), E = inst_end(F); I != E; ++I) {
       const Instruction* i = &(*I);
       const Type *type = i->getType();
+      if(const CallInst* call = dyn_cast<CallInst>(i))
+        if(call->getCalledFunction() == NULL 
+        and !isa<InlineAsm>(call->getCalledValue()))
+          indirect_calls.push_back(call);
+      if(const LoadInst* ld = dyn_cast<LoadInst>(i))
+        all_loads.push_back(ld);
+      else if(const StoreInst* st = dyn_cast<StoreInst>(i))
+        all_stores.push_back(st);
       if(type->isPointerTy())
         all_pointers.insert(i);
       else if(const StoreInst* str_int = dyn_cast<StoreInst>(i)) {
@@ -316,8 +982,12 @@ void OffsetBasedAliasAnalysis::buildIntraProceduralDepGraph() {
   for(auto *i : all_pointers) {
     offset_pointers[i] = new OffsetPointer(i);
   }
+  // arguments are typed first, so the addresses on them know whether they
+  // are unique
+  for(auto i : offset_pointers)
+    if(isa<Argument>(i.first)) i.second->addIntraProceduralAddresses(this);
   for(auto i : offset_pointers) {
-    i.second->addIntraProceduralAddresses(this);
+    if(!isa<Argument>(i.first)) i.second->addIntraProceduralAddresses(this);
     if(i.second->addr_empty())
       if(i.second->getPointerType() == OffsetPointer::Cont
       or i.second->getPointerType() == OffsetPointer::Phi)
@@ -550,6 +1220,15 @@ void OffsetBasedAliasAnalysis::getNarrowingInfo() {
   }
 }
 
+/// \brief Builds the relational constraints of each function
+void OffsetBasedAliasAnalysis::buildDifferenceBounds(Module &M) {
+  difference_bounds = new DifferenceBounds(DifferenceBoundsMaxVars);
+  for (auto F = M.begin(), Fe = M.end(); F != Fe; F++)
+    if(!F->isDeclaration())
+      difference_bounds->build(*F, M.getDataLayout());
+  DEBUG_WITH_TYPE("zones", difference_bounds->print());
+}
+
 // Depth first searches
 /// \brief transpost DFS based on color
 void OffsetBasedAliasAnalysis::DFS_visit_t(OffsetPointer* u, 
@@ -715,6 +1394,24 @@ void OffsetBasedAliasAnalysis::resolveWholeGraph() {
   }
 }
 
+/// \brief Forgets the allocation size of every base that reaches the first
+/// argument of a realloc. The reallocated pointer is modeled on the same
+/// base as that argument, but its object may be larger than the one the
+/// base was allocated with.
+void OffsetBasedAliasAnalysis::dropReallocatedSizes() {
+  const TargetLibraryInfo* TLI = getTargetLibraryInfo();
+  std::vector<OffsetPointer*> bases;
+  std::vector<Offset> offsets;
+  for(auto p : offset_pointers) {
+    if(!isReallocLikeFn(p.first, TLI, true)) continue;
+    bases.clear();
+    offsets.clear();
+    getBases(p.second, bases, offsets);
+    for(auto b : bases)
+      b->alloc_size_lo = b->alloc_size_hi = -1;
+  }
+}
+
 /// \brief Applies the windening operators present in the graph
 void OffsetBasedAliasAnalysis::applyWidening() {
   for(auto p : offset_pointers) {
@@ -723,6 +1420,10 @@ void OffsetBasedAliasAnalysis::applyWidening() {
         a->offset.widen(wo.second);
         a->widened = true;
       }
+      //a pointer used for accesses stays inside its object or one past it,
+      // so the widened offset can be clamped by the allocation size
+      if(a->widened and a->base->hasAllocSize())
+        a->offset.clamp(0, a->base->getAllocSizeUpper());
     }
   }
 }
@@ -738,34 +1439,742 @@ void OffsetBasedAliasAnalysis::applyNarrowing() {
   }
 }
 
-/// \brief Analyzes the function F to verify if it returns a local alloc
-void OffsetBasedAliasAnalysis::analyzeFunction(const Function* F) {
-  // if all returned pointers are local allocation this function
-  // gets a true entry
+/// \brief Gives loads from tracked objects the addresses of the pointers
+/// stored to them. Each round may let more loads be modeled, since loaded
+/// pointers become derived from their objects once the graph is solved
+/// again.
+void OffsetBasedAliasAnalysis::modelMemory() {
+  seedGlobalContents();
+  for(unsigned round = 0; round < MemoryRounds; round++) {
+    if(!modelMemoryRound()) break;
+    
+    // the modeled loads are phis now, the graph is solved again
+    for(auto p : offset_pointers)
+      for(auto a : p.second->addresses)
+        a->expanded.clear();
+    std::map<int,std::pair<OffsetPointer*, int> > sccs = findSCCs();
+    resolveSCCs(sccs);
+    resolveWholeGraph();
+  }
+}
 
-  //This for loop tries prove the contrary and give the function a false entry
-  for (auto i = inst_begin(F), e = inst_end(F); i != e; i++)
-    if(isa<const ReturnInst>(*i)) {
-      //getting the returned pointer
-      const Value* ret_ptr = ((ReturnInst*)&(*i))->getReturnValue();
-      OffsetPointer* ret_optr = getOffsetPointer(ret_ptr);
-
-      //if the returned value is not a pointer, there is something wrong
-      assert(ret_optr != NULL);
-
-      //if the pointer is not a local allocation or one of it's addresses
-      // bases aren't local allocations then the function gets a false entry 
-      if(ret_optr->pointer_type != OffsetPointer::Alloc)
-        for(auto a : ret_optr->addresses)
-          if(a->base->pointer_type != OffsetPointer::Alloc) {
-            //the function does not return local allocation
-            allocFunctions[F] = false;
-            return;
+/// \brief A single round of modelMemory. The pointers to an object are
+/// the ones derived from it and, when they are stored into memory, the
+/// ones derived from the loads that may read them back. An object is 
+/// tracked when all these pointers are only loaded from, stored to or
+/// compared, and only stored into tracked objects, so every store to it
+/// is seen. Internal globals start with their initializers and constant
+/// globals are never written, so they are tracked as they are. A pointer
+/// load from tracked objects then gets every pointer stored or initialized
+/// where it may read, unless non pointer data may be read as well or a 
+/// stored pointer depends on a load modeled in the same round.
+bool OffsetBasedAliasAnalysis::modelMemoryRound() {
+  // loads and stores by the bases of their addresses
+  std::map<OffsetPointer*, std::vector<const LoadInst*> > loads_of;
+  std::map<OffsetPointer*, std::vector<const StoreInst*> > stores_of;
+  std::vector<OffsetPointer*> bases;
+  std::vector<Offset> offsets;
+  for(auto l : all_loads)
+    if(OffsetPointer* a = findOffsetPointer(l->getPointerOperand())) {
+      bases.clear();
+      offsets.clear();
+      getBases(a, bases, offsets);
+      for(auto b : bases) loads_of[b].push_back(l);
+    }
+  for(auto st : all_stores)
+    if(OffsetPointer* a = findOffsetPointer(st->getPointerOperand())) {
+      bases.clear();
+      offsets.clear();
+      getBases(a, bases, offsets);
+      for(auto b : bases) stores_of[b].push_back(st);
+    }
+  
+  // objects whose pointers never leave the graph. The pointers to each
+  // object grow with the loads that may read them back, from the object
+  // where they are stored or through loaded pointers to it, until none
+  // grows.
+  std::vector<OffsetPointer*> objects;
+  std::map<OffsetPointer*, std::set<OffsetPointer*> > pointers_to;
+  std::map<OffsetPointer*, std::set<OffsetPointer*> > stored_in;
+  std::set<OffsetPointer*> escaping;
+  auto add = [&](std::set<OffsetPointer*> &Derived, OffsetPointer* N) {
+    if(!Derived.insert(N).second) return false;
+    std::vector<OffsetPointer*> work(1, N);
+    while(!work.empty()) {
+      OffsetPointer* w = work.back();
+      work.pop_back();
+      for(auto a : w->bases)
+        if(Derived.insert(a->addressee).second) 
+          work.push_back(a->addressee);
+    }
+    return true;
+  };
+  std::set<OffsetPointer*> tracked;
+  for(auto p : offset_pointers) {
+    OffsetPointer* o = p.second;
+    if(o->pointer_type == OffsetPointer::Global) {
+      if(!global_contents.count(o)) continue;
+      if(cast<GlobalVariable>(o->pointer)->isConstant()) {
+        tracked.insert(o);
+        continue;
+      }
+    }
+    else if(o->pointer_type != OffsetPointer::Alloc) continue;
+    else if(!isa<AllocaInst>(o->pointer) and !ImmutableCallSite(o->pointer)) 
+      continue;
+    objects.push_back(o);
+    add(pointers_to[o], o);
+  }
+  bool grown = true;
+  while(grown) {
+    grown = false;
+    for(auto o : objects) {
+      if(escaping.count(o)) continue;
+      std::set<OffsetPointer*> &derived = pointers_to[o];
+      std::vector<OffsetPointer*> work(derived.begin(), derived.end());
+      for(auto n : work)
+        for(auto u : n->pointer->users()) {
+          const StoreInst* st = dyn_cast<StoreInst>(u);
+          if(st == NULL or st->getValueOperand() != n->pointer) continue;
+          OffsetPointer* a = findOffsetPointer(st->getPointerOperand());
+          if(a == NULL) {
+            escaping.insert(o);
+            continue;
+          }
+          bases.clear();
+          offsets.clear();
+          getBases(a, bases, offsets);
+          for(auto b : bases) {
+            stored_in[o].insert(b);
+            std::vector<const LoadInst*> readers = loads_of[b];
+            auto to_b = pointers_to.find(b);
+            if(to_b != pointers_to.end())
+              for(auto x : to_b->second)
+                if(isa<LoadInst>(x->pointer) and x->addr_empty())
+                  readers.insert(readers.end(), loads_of[x].begin(),
+                    loads_of[x].end());
+            for(auto l : readers) {
+              OffsetPointer* ln = findOffsetPointer(l);
+              if(ln == NULL) escaping.insert(o);
+              else if(add(derived, ln)) grown = true;
+            }
           }
+        }
+    }
+  }
+  for(auto o : objects) {
+    if(escaping.count(o)) continue;
+    bool escapes = false;
+    const std::set<OffsetPointer*> &derived = pointers_to[o];
+    for(auto d = derived.begin(), de = derived.end(); d != de and !escapes; 
+    d++)
+      for(auto u : (*d)->pointer->users())
+        if(!isTrackedUse(u, (*d)->pointer, derived))
+          escapes = true;
+    if(!escapes) tracked.insert(o);
+  }
+  
+  // objects stored into memory that is not tracked may be reached by
+  // unknown pointers
+  bool changed = true;
+  while(changed) {
+    changed = false;
+    for(auto o = tracked.begin(); o != tracked.end(); ) {
+      bool keep = true;
+      for(auto b : stored_in[*o])
+        if(!tracked.count(b)) keep = false;
+      if(keep) o++;
+      else {
+        o = tracked.erase(o);
+        changed = true;
+      }
+    }
+  }
+  NumTrackedObjects = tracked.size();
+  
+  // pointer loads whose bases are all tracked
+  std::set<OffsetPointer*> pending;
+  for(auto l : all_loads) {
+    if(!l->getType()->isPointerTy() or modeled_loads.count(l)) continue;
+    OffsetPointer* a = findOffsetPointer(l->getPointerOperand());
+    if(a == NULL) continue;
+    bases.clear();
+    offsets.clear();
+    getBases(a, bases, offsets);
+    bool all_tracked = true;
+    for(auto b : bases) 
+      if(!tracked.count(b)) all_tracked = false;
+    if(all_tracked) pending.insert(findOffsetPointer(l));
+  }
+  
+  bool modeled = false;
+  for(auto l : all_loads) {
+    OffsetPointer* ln = findOffsetPointer(l);
+    if(ln == NULL or !pending.count(ln)) continue;
+    std::vector<OffsetPointer*> lbases;
+    std::vector<Offset> loffsets;
+    getBases(findOffsetPointer(l->getPointerOperand()), lbases, loffsets);
+    uint64_t load_size = getDataLayout()->getTypeStoreSize(l->getType());
+    
+    // stores to the same base whose bytes may overlap the loaded ones
+    std::set<OffsetPointer*> values;
+    bool conflict = false;
+    for(unsigned i = 0; i < lbases.size(); i++) {
+      if(!readInitializer(l, lbases[i], loffsets[i], values)) conflict = true;
+      // stores through loaded pointers to the object, at unknown offsets
+      for(auto x : pointers_to[lbases[i]]) {
+        if(!isa<LoadInst>(x->pointer) or !x->addr_empty()) continue;
+        for(auto st : stores_of[x]) {
+          OffsetPointer* v = findOffsetPointer(st->getValueOperand());
+          if(v == NULL) conflict = true;
+          else values.insert(v);
+        }
+      }
+      for(auto st : stores_of[lbases[i]]) {
+        uint64_t store_size = getDataLayout()->getTypeStoreSize(
+          st->getValueOperand()->getType());
+        std::vector<OffsetPointer*> sbases;
+        std::vector<Offset> soffsets;
+        getBases(findOffsetPointer(st->getPointerOperand()), sbases, 
+          soffsets);
+        for(unsigned j = 0; j < sbases.size(); j++) {
+          if(sbases[j] != lbases[i] 
+          or soffsets[j].disjoint(loffsets[i], store_size, load_size))
+            continue;
+          if(differentFields(st->getPointerOperand(), 
+          l->getPointerOperand(), lbases[i])) continue;
+          OffsetPointer* v = findOffsetPointer(st->getValueOperand());
+          if(v == NULL) conflict = true;
+          else values.insert(v);
+        }
+      }
+    }
+    // values that depend on loads of this round would make a cycle, and
+    // noalias arguments are unique only in their own function
+    for(auto v : values) {
+      bases.clear();
+      offsets.clear();
+      getBases(v, bases, offsets);
+      for(auto b : bases) {
+        if(pending.count(b)) conflict = true;
+        if(const Argument* arg = dyn_cast<Argument>(b->pointer))
+          if(b->pointer_type == OffsetPointer::Alloc and !arg->hasByValAttr()
+          and arg->getParent() != l->getParent()->getParent())
+            conflict = true;
+      }
+    }
+    if(conflict) continue;
+    
+    for(auto v : values)
+      new Address(ln, v, Offset());
+    if(!values.empty()) {
+      ln->pointer_type = OffsetPointer::Phi;
+      NumUnkPointers--;
     }
+    modeled_loads.insert(l);
+    NumModeledLoads++;
+    modeled = true;
+  }
+  return modeled;
+}
 
-  //Else, the function gets a true entry
-  allocFunctions[F] = true;
+/// \brief Finds the field \p P points to, as the struct type \p S whose
+/// element the trailing constant indices of P's getelementptr select from
+/// and the byte offset \p Field of the selected member in S. The 
+/// getelementptr must index object \p O itself or a cast of it, a view
+/// such as (S*)((char*)O + 8) does not start at an element of O.
+static bool getFieldCell(const Value* P, const Value* O, const DataLayout* DL,
+StructType*& S, uint64_t& Field) {
+  const GEPOperator* gep = dyn_cast<GEPOperator>(P);
+  if(DL == NULL or gep == NULL) return false;
+  const Value* root = gep->getPointerOperand();
+  if(root != O and (Operator::getOpcode(root) != Instruction::BitCast
+  or cast<Operator>(root)->getOperand(0) != O))
+    return false;
+  
+  // the first struct indexed by a constant after which all indices are
+  // constant as well
+  S = NULL;
+  SmallVector<Value*, 8> suffix;
+  for(auto i = gep_type_begin(gep), e = gep_type_end(gep); i != e; i++) {
+    Value* index = i.getOperand();
+    if(!isa<ConstantInt>(index)) {
+      S = NULL;
+      suffix.clear();
+      continue;
+    }
+    if(S == NULL) {
+      S = dyn_cast<StructType>(*i);
+      if(S == NULL) continue;
+      suffix.push_back(ConstantInt::get(index->getType(), 0));
+    }
+    suffix.push_back(index);
+  }
+  if(S == NULL) return false;
+  Field = DL->getIndexedOffset(PointerType::getUnqual(S), suffix);
+  return true;
+}
+
+/// \brief Answers whether object \p O is laid out as elements of struct 
+/// type \p S: a single one or an array of them for allocas and globals,
+/// and every cast to S pointers for allocation calls
+static bool hasStructElements(const Value* O, const StructType* S) {
+  Type* t = NULL;
+  if(const AllocaInst* alloca = dyn_cast<AllocaInst>(O)) 
+    t = alloca->getAllocatedType();
+  else if(const GlobalVariable* global = dyn_cast<GlobalVariable>(O))
+    t = global->getType()->getElementType();
+  if(t != NULL) {
+    if(ArrayType* array = dyn_cast<ArrayType>(t)) t = array->getElementType();
+    return t == S;
+  }
+  bool cast = false;
+  for(auto u : O->users())
+    if(const BitCastInst* bc = dyn_cast<BitCastInst>(u)) {
+      if(bc->getType()->getPointerElementType() != S) return false;
+      cast = true;
+    }
+  return cast;
+}
+
+/// \brief Answers whether the accesses through \p A and \p B are to 
+/// different fields of the struct elements of object \p O. Struct 
+/// elements of an object start at multiples of the struct size, so
+/// different members are different memory even when the elements' indices
+/// are unknown, as long as both accesses index O as such elements.
+bool OffsetBasedAliasAnalysis::differentFields(const Value* A, 
+const Value* B, const OffsetPointer* O) const {
+  StructType *SA, *SB;
+  uint64_t fieldA, fieldB;
+  if(!getFieldCell(A, O->pointer, getDataLayout(), SA, fieldA)
+  or !getFieldCell(B, O->pointer, getDataLayout(), SB, fieldB))
+    return false;
+  return SA == SB and fieldA != fieldB and hasStructElements(O->pointer, SA);
+}
+
+/// \brief Adds to \p Cells the scalars of constant \p C, placed \p At 
+/// bytes into the global it initializes. Zeroed aggregates and constant 
+/// data arrays are kept whole, as they hold no pointer but null.
+static void getConstantCells(const Constant* C, int64_t At, 
+const DataLayout* DL, 
+std::vector<std::pair<int64_t, const Constant*> > &Cells) {
+  Type* t = C->getType();
+  if(isa<UndefValue>(C)) return;
+  if(isa<ConstantAggregateZero>(C) or isa<ConstantDataSequential>(C)) {
+    Cells.push_back(std::make_pair(At, C));
+  }
+  else if(StructType* s = dyn_cast<StructType>(t)) {
+    const StructLayout* layout = DL->getStructLayout(s);
+    for(unsigned i = 0, n = s->getNumElements(); i < n; i++)
+      getConstantCells(C->getAggregateElement(i), 
+        At + layout->getElementOffset(i), DL, Cells);
+  }
+  else if(isa<ArrayType>(t) or isa<VectorType>(t)) {
+    Type* element = cast<SequentialType>(t)->getElementType();
+    int64_t size = DL->getTypeAllocSize(element);
+    uint64_t n = isa<ArrayType>(t) ? cast<ArrayType>(t)->getNumElements()
+      : cast<VectorType>(t)->getNumElements();
+    for(uint64_t i = 0; i < n; i++)
+      getConstantCells(C->getAggregateElement(i), At + i*size, DL, Cells);
+  }
+  else {
+    Cells.push_back(std::make_pair(At, C));
+  }
+}
+
+/// \brief Records the initializers of the globals whose contents are known
+/// from the start: constant ones, and internal ones that modelMemory may
+/// track. Their pointers are added to the graph only when a load reads 
+/// them.
+void OffsetBasedAliasAnalysis::seedGlobalContents() {
+  const DataLayout* DL = getDataLayout();
+  if(DL == NULL) return;
+  for(auto p : offset_pointers) {
+    const GlobalVariable* g = dyn_cast<GlobalVariable>(p.first);
+    if(g == NULL or !g->hasDefinitiveInitializer()) continue;
+    if(!g->isConstant() and !g->hasLocalLinkage()) continue;
+    getConstantCells(g->getInitializer(), 0, DL, global_contents[p.second]);
+  }
+}
+
+/// \brief Returns the offset pointer of the constant \p C, adding it and 
+/// its operands to the graph if they are not there yet
+OffsetPointer* OffsetBasedAliasAnalysis::getConstantPointer(
+const Constant* C) {
+  if(OffsetPointer* p = findOffsetPointer(C)) return p;
+  if(const ConstantExpr* e = dyn_cast<ConstantExpr>(C))
+    for(auto &op : e->operands())
+      if(op->getType()->isPointerTy())
+        getConstantPointer(cast<Constant>(op.get()));
+  all_pointers.insert(C);
+  OffsetPointer* p = getOffsetPointer(C);
+  p->addIntraProceduralAddresses(this);
+  if(p->addr_empty())
+    if(p->getPointerType() == OffsetPointer::Cont
+    or p->getPointerType() == OffsetPointer::Phi)
+      p->setPointerType(OffsetPointer::Unk);
+  if(p->getPointerType() == OffsetPointer::Unk) NumUnkPointers++;
+  return p;
+}
+
+/// \brief Adds to \p Values the pointers \p L may read from the 
+/// initializer of \p G at offset \p O. A field of struct elements is
+/// read in every element, any other load must have bounded offsets. 
+/// Answers false when L may read non pointer data or part of a pointer.
+bool OffsetBasedAliasAnalysis::readInitializer(const LoadInst* L, 
+const OffsetPointer* G, const Offset &O, std::set<OffsetPointer*> &Values) {
+  auto contents = global_contents.find(G);
+  if(contents == global_contents.end()) return true;
+  const DataLayout* DL = getDataLayout();
+  int64_t lo, hi;
+  O.getBounds(lo, hi);
+  StructType* S;
+  uint64_t field;
+  int64_t stride = 0;
+  if(getFieldCell(L->getPointerOperand(), G->pointer, DL, S, field)
+  and hasStructElements(G->pointer, S))
+    stride = DL->getTypeAllocSize(S);
+  else if(lo == INT64_MIN or hi == INT64_MAX)
+    return false;
+  int64_t size = DL->getTypeStoreSize(L->getType());
+  
+  for(auto c : contents->second) {
+    int64_t at = c.first;
+    int64_t end = at + DL->getTypeStoreSize(c.second->getType());
+    bool overlaps, exact;
+    if(stride != 0) {
+      // the first position of the field whose read may reach the cell
+      int64_t first = at - size + 1;
+      int64_t skip = ((int64_t)field - first) % stride;
+      if(skip < 0) skip += stride;
+      overlaps = first + skip < end;
+      exact = at % stride == (int64_t)field;
+    } else {
+      // a load that may start anywhere else in [lo, hi] may read part
+      // of the cell
+      overlaps = at < hi + size and end > lo;
+      exact = lo == hi and lo == at;
+    }
+    if(!overlaps) continue;
+    if(isa<ConstantAggregateZero>(c.second))
+      Values.insert(getConstantPointer(
+        ConstantPointerNull::get(cast<PointerType>(L->getType()))));
+    else if(exact and c.second->getType()->isPointerTy()
+    and end - at == size)
+      Values.insert(getConstantPointer(c.second));
+    else
+      return false;
+  }
+  return true;
+}
+
+/// \brief Answers whether \p U, a user of \p V, keeps every pointer to
+/// the object of \p Derived in the graph. Stores of V are followed by
+/// the caller.
+bool OffsetBasedAliasAnalysis::isTrackedUse(const User* U, const Value* V,
+const std::set<OffsetPointer*> &Derived) const {
+  if(isa<LoadInst>(U) or isa<StoreInst>(U) or isa<ICmpInst>(U) 
+  or isa<DbgInfoIntrinsic>(U))
+    return true;
+  if(const IntrinsicInst* ii = dyn_cast<IntrinsicInst>(U))
+    if(ii->getIntrinsicID() == Intrinsic::lifetime_start
+    or ii->getIntrinsicID() == Intrinsic::lifetime_end)
+      return true;
+  OffsetPointer* n = findOffsetPointer(U);
+  return n != NULL and Derived.count(n);
+}
+
+/// \brief Marks the allocs that pointers outside the graph may reach. An
+/// alloc escapes when some pointer with an address on it is stored to
+/// memory, returned, passed to a call that may capture it, or used by
+/// anything but loads, stores to it, comparisons and the pointers derived
+/// from it. Every other pointer in the graph that may reach the alloc then
+/// has an address on it.
+void OffsetBasedAliasAnalysis::findEscapingObjects() {
+  std::map<OffsetPointer*, std::set<OffsetPointer*> > derived;
+  for(auto p : offset_pointers)
+    for(auto a : p.second->addresses)
+      derived[a->base].insert(p.second);
+  
+  NumLocalObjects = 0;
+  for(auto &d : derived) {
+    OffsetPointer* o = d.first;
+    o->escapes = true;
+    if(o->pointer_type != OffsetPointer::Alloc) continue;
+    bool escapes = false;
+    for(auto n = d.second.begin(), ne = d.second.end(); n != ne and !escapes; 
+    n++)
+      for(auto u : (*n)->pointer->users())
+        if(!isLocalUse(u, (*n)->pointer, d.second))
+          escapes = true;
+    o->escapes = escapes;
+    if(!escapes) NumLocalObjects++;
+  }
+}
+
+/// \brief Answers whether \p U, a user of \p V, keeps the object of 
+/// \p Derived from escaping. Calls may use V as long as they do not
+/// capture it.
+bool OffsetBasedAliasAnalysis::isLocalUse(const User* U, const Value* V,
+const std::set<OffsetPointer*> &Derived) const {
+  if(const StoreInst* st = dyn_cast<StoreInst>(U))
+    return st->getValueOperand() != V;
+  ImmutableCallSite CS(U);
+  if(CS) {
+    for(unsigned k = 0, n = CS.arg_size(); k < n; k++)
+      if(CS.getArgument(k) == V and !CS.doesNotCapture(k)) return false;
+    return true;
+  }
+  return isTrackedUse(U, V, Derived);
+}
+
+/// \brief Gives the bases identifiers and builds the pointers' triples
+void OffsetBasedAliasAnalysis::buildAddressTriples() {
+  int64_t next_id = 1;
+  for(auto p : offset_pointers)
+    p.second->base_id = 0;
+  for(auto p : offset_pointers) {
+    OffsetPointer* op = p.second;
+    op->triples.clear();
+    for(auto a : op->addresses) {
+      OffsetPointer* base = a->base;
+      if(base->base_id == 0) {
+        if(base->pointer_type == OffsetPointer::Unk) base->base_id = -next_id;
+        else base->base_id = next_id;
+        next_id++;
+      }
+      int64_t lo, hi;
+      a->offset.getBounds(lo, hi);
+      op->triples.add(base->base_id, lo, hi);
+    }
+  }
+  
+  //signatures are built once every base has its identifier
+  for(auto p : offset_pointers) {
+    OffsetPointer* op = p.second;
+    op->base_signature = 0;
+    op->unk_signature = 0;
+    op->arg_signature = isSharedArgument(op);
+    for(auto a : op->addresses) {
+      int64_t id = a->base->base_id;
+      if(id > 0) 
+        op->base_signature |= UINT64_C(1) << (id % 64);
+      else if(op->unk_signature == 0)
+        op->unk_signature = id;
+      else if(op->unk_signature != id)
+        op->unk_signature = INT64_MIN;
+      if(a->argument) op->arg_signature = true;
+    }
+  }
+  num_base_ids = next_id;
+}
+
+/// \brief Partitions the pointers without unknown bases into may alias
+/// classes, joining the bases that appear together in a pointer
+void OffsetBasedAliasAnalysis::buildAliasClasses() {
+  IntEqClasses classes(num_base_ids);
+  for(auto p : offset_pointers) {
+    const AddressTriples& t = p.second->triples;
+    for(unsigned i = 1; i < t.size(); i++)
+      if(t.bases[0] > 0 and t.bases[i] > 0)
+        classes.join(t.bases[0], t.bases[i]);
+  }
+  classes.compress();
+  
+  for(auto p : offset_pointers) {
+    OffsetPointer* op = p.second;
+    op->alias_class = -1;
+    if(op->triples.size() == 0) continue;
+    bool unknown = false;
+    for(auto b : op->triples.bases)
+      if(b < 0) unknown = true;
+    if(!unknown) op->alias_class = classes[op->triples.bases[0]];
+  }
+}
+
+/// \brief Computes the Mod/Ref summaries of all functions up to a fixed
+/// point over the calls between them. Summaries only grow, so the
+/// iteration stops once no summary changes size.
+void OffsetBasedAliasAnalysis::buildModRefSummaries(Module &M) {
+  modref_summaries.clear();
+  for(auto F = M.begin(), Fe = M.end(); F != Fe; F++)
+    if(!F->isDeclaration()) modref_summaries[F] = ModRefSummary();
+  
+  bool changed = true;
+  while(changed) {
+    changed = false;
+    for(auto F = M.begin(), Fe = M.end(); F != Fe; F++) {
+      if(F->isDeclaration()) continue;
+      ModRefSummary &s = modref_summaries[F];
+      unsigned before = s.size();
+      for (inst_iterator I = inst_begin(F), E = inst_end(F); I != E; ++I)
+        summarizeInstruction(s, F, &(*I));
+      if(s.size() != before) changed = true;
+    }
+  }
+}
+
+/// \brief Adds to \p S the effect of instruction \p I of function \p F
+void OffsetBasedAliasAnalysis::summarizeInstruction(ModRefSummary &S, 
+const Function* F, const Instruction* I) {
+  if(const LoadInst* l = dyn_cast<LoadInst>(I)) {
+    summarizeAccess(S, F, l->getPointerOperand(), false);
+    return;
+  }
+  if(const StoreInst* s = dyn_cast<StoreInst>(I)) {
+    summarizeAccess(S, F, s->getPointerOperand(), true);
+    return;
+  }
+  const Value* rmw = NULL;
+  if(const AtomicRMWInst* a = dyn_cast<AtomicRMWInst>(I))
+    rmw = a->getPointerOperand();
+  else if(const AtomicCmpXchgInst* a = dyn_cast<AtomicCmpXchgInst>(I))
+    rmw = a->getPointerOperand();
+  else if(const VAArgInst* a = dyn_cast<VAArgInst>(I))
+    rmw = a->getPointerOperand();
+  if(rmw) {
+    summarizeAccess(S, F, rmw, false);
+    summarizeAccess(S, F, rmw, true);
+    return;
+  }
+  
+  ImmutableCallSite CS(I);
+  if(!CS or isa<DbgInfoIntrinsic>(I) or CS.doesNotAccessMemory()) return;
+  
+  if(const MemIntrinsic* mi = dyn_cast<MemIntrinsic>(I)) {
+    summarizeAccess(S, F, mi->getRawDest(), true);
+    if(const MemTransferInst* mt = dyn_cast<MemTransferInst>(mi))
+      summarizeAccess(S, F, mt->getRawSource(), false);
+    return;
+  }
+  
+  // Callee summaries are translated through the actual arguments. A copy
+  // is taken since the callee may be F itself.
+  const Function* callee = CS.getCalledFunction();
+  auto c = callee ? modref_summaries.find(callee) : modref_summaries.end();
+  if(c != modref_summaries.end()) {
+    ModRefSummary summary = c->second;
+    for(auto k : summary.mod_args)
+      summarizeAccess(S, F, CS.getArgument(k), true);
+    for(auto k : summary.ref_args)
+      summarizeAccess(S, F, CS.getArgument(k), false);
+    S.mod_bases.insert(summary.mod_bases.begin(), summary.mod_bases.end());
+    S.ref_bases.insert(summary.ref_bases.begin(), summary.ref_bases.end());
+    S.mod_unknown |= summary.mod_unknown;
+    S.ref_unknown |= summary.ref_unknown;
+    return;
+  }
+  
+  // Declarations and indirect calls rely on their attributes
+  bool mod = !CS.onlyReadsMemory();
+  if(CS.onlyAccessesArgMemory()) {
+    for(unsigned k = 0; k < CS.arg_size(); k++) {
+      const Value* arg = CS.getArgument(k);
+      if(!arg->getType()->isPointerTy()) continue;
+      summarizeAccess(S, F, arg, false);
+      if(mod) summarizeAccess(S, F, arg, true);
+    }
+    return;
+  }
+  S.ref_unknown = true;
+  if(mod) S.mod_unknown = true;
+}
+
+/// \brief Adds to \p S an access of function \p F through \p P. Accesses
+/// to F's own stack are dropped, accesses through F's arguments are kept
+/// by position and the remaining bases are kept as they are. An alloca of
+/// F is its own frame only when P is in the alloca's local tree, derived
+/// from it by SSA alone. Reached through an argument or a loaded pointer,
+/// it may be the frame of an outer activation of a recursive F.
+void OffsetBasedAliasAnalysis::summarizeAccess(ModRefSummary &S, 
+const Function* F, const Value* P, bool Mod) {
+  bool &unknown = Mod ? S.mod_unknown : S.ref_unknown;
+  std::set<unsigned> &args = Mod ? S.mod_args : S.ref_args;
+  std::set<const OffsetPointer*> &bases = Mod ? S.mod_bases : S.ref_bases;
+  
+  OffsetPointer* op = findOffsetPointer(P);
+  if(op == NULL or op->addr_empty()) {
+    unknown = true;
+    return;
+  }
+  for(auto a : op->addresses) {
+    OffsetPointer* base = a->base;
+    const Value* v = base->pointer;
+    if(base->pointer_type == OffsetPointer::Null) continue;
+    if(const Argument* arg = dyn_cast<Argument>(v))
+      if(arg->getParent() == F) {
+        args.insert(arg->getArgNo());
+        continue;
+      }
+    if(const AllocaInst* alloca = dyn_cast<AllocaInst>(v))
+      if(alloca->getParent()->getParent() == F and op->local_root == base)
+        continue;
+    if(base->pointer_type == OffsetPointer::Unk) unknown = true;
+    else bases.insert(base->origin);
+  }
+}
+
+/// \brief Finds the functions that return fresh allocations. The SCCs of
+/// the call graph are visited bottom up, so callees are known before their
+/// callers. The functions of an SCC are assumed to return fresh allocations
+/// until one of them is proved not to, which is repeated to a fixed point.
+void OffsetBasedAliasAnalysis::analyzeCallGraph() {
+  CallGraph &CG = getAnalysis<CallGraphWrapperPass>().getCallGraph();
+  allocFunctions.clear();
+  for(scc_iterator<CallGraph*> I = scc_begin(&CG); !I.isAtEnd(); ++I) {
+    std::vector<const Function*> scc;
+    for(auto node : *I) {
+      const Function* F = node->getFunction();
+      if(F == NULL or F->isDeclaration()) continue;
+      if(!F->getReturnType()->isPointerTy()) continue;
+      scc.push_back(F);
+      allocFunctions[F] = true;
+    }
+    
+    bool changed = true;
+    while(changed) {
+      changed = false;
+      for(auto F : scc)
+        if(allocFunctions[F] and !analyzeFunction(F)) {
+          allocFunctions[F] = false;
+          changed = true;
+        }
+    }
+  }
+}
+
+/// \brief Answers whether F returns a fresh allocation. Every returned
+/// pointer must be null or based on allocations or on calls to functions
+/// that return fresh allocations, and those must not be captured other
+/// than by the return itself.
+bool OffsetBasedAliasAnalysis::analyzeFunction(const Function* F) {
+  for (auto i = inst_begin(F), e = inst_end(F); i != e; i++)
+    if(const ReturnInst* ret = dyn_cast<ReturnInst>(&(*i))) {
+      //getting the returned pointer
+      OffsetPointer* ret_optr = findOffsetPointer(ret->getReturnValue());
+      if(ret_optr == NULL) return false;
+
+      std::vector<OffsetPointer*> bases;
+      if(ret_optr->addr_empty()) bases.push_back(ret_optr);
+      for(auto a : ret_optr->addresses)
+        bases.push_back(a->base);
+      
+      for(auto base : bases) {
+        if(base->pointer_type == OffsetPointer::Null) continue;
+        ImmutableCallSite call(base->pointer);
+        if(!call) return false;
+        if(base->pointer_type == OffsetPointer::Call) {
+          const Function* CF = call.getCalledFunction();
+          auto r = CF ? allocFunctions.find(CF) : allocFunctions.end();
+          if(r == allocFunctions.end() or !r->second) return false;
+        }
+        else if(base->pointer_type != OffsetPointer::Alloc)
+          return false;
+        //the allocation cannot be reachable from anywhere else
+        if(PointerMayBeCaptured(base->pointer, false, true)) return false;
+      }
+    }
+  return true;
 }
 
 /// \brief Updates the call insts to allocs if the called function returns
@@ -776,13 +2185,11 @@ void OffsetBasedAliasAnalysis::updateCalls() {
       //get called function
       const CallInst* c = dyn_cast<CallInst>(p.first);
       const Function* CF = c->getCalledFunction();
-      if(CF){
-        if(allocFunctions.find(CF) == allocFunctions.end())
-          analyzeFunction(CF);
-        //if the function returns a local allocation then the pointer
-        // is an allocation since only pointers of the same function are
-        // compared
-        if(allocFunctions[CF]){
+      auto r = CF ? allocFunctions.find(CF) : allocFunctions.end();
+      if(r != allocFunctions.end()){
+        //if the function returns a fresh allocation then the pointer
+        // is an allocation as well
+        if(r->second){
           p.second->pointer_type = OffsetPointer::Alloc;
           NumUnkPointers--;
         }
@@ -792,12 +2199,38 @@ void OffsetBasedAliasAnalysis::updateCalls() {
 }
 
 /// \brief Adds addresses to arguments and calls to make the dependence graph
-///  interprocedural
+///  interprocedural. Calls to small functions get the callee's returned
+///  bases in their own context, the others are wired to the callee's
+///  returned values.
 void OffsetBasedAliasAnalysis::addInterProceduralEdges() {
+  // Instantiations read the intra procedural graph, so they are all done
+  // before any edge is added
+  std::map<OffsetPointer*, BaseList> instances;
+  num_context_clones = 0;
+  if(ContextDepth > 0)
+    for(auto p : offset_pointers)
+      if(p.second->pointer_type == OffsetPointer::Call) {
+        BaseList bases;
+        if(instantiateCall(cast<CallInst>(p.first), bases))
+          instances[p.second].swap(bases);
+      }
+  
   for(auto p : offset_pointers) {
     if (p.second->pointer_type == OffsetPointer::Call
     or p.second->pointer_type == OffsetPointer::Arg) {
-      p.second->addInterProceduralAddresses(this);
+      auto instance = instances.find(p.second);
+      if(instance != instances.end()) {
+        for(auto &b : instance->second)
+          new Address(p.second, b.first, b.second);
+      }
+      //a call that may reach unseen functions, or an argument that unseen
+      // callers may give a value, keeps no addresses
+      else if(const CallInst* call = dyn_cast<CallInst>(p.first)) {
+        if(!hasUnresolvedTargets(call))
+          p.second->addInterProceduralAddresses(this);
+      }
+      else if(!hasUnseenCallers(cast<Argument>(p.first)->getParent()))
+        p.second->addInterProceduralAddresses(this);
 
       //If addresses were added the pointer is no longer unknown,
       // if no addresses were added then the pointer is really unknown
@@ -812,6 +2245,343 @@ void OffsetBasedAliasAnalysis::addInterProceduralEdges() {
   }
 }
 
+/// \brief Answers whether calls to \p F may instantiate its summary, it
+/// must be defined, return a pointer and be small enough
+bool OffsetBasedAliasAnalysis::isInstantiable(const Function* F) const {
+  if(F == NULL or F->isDeclaration() or !F->getReturnType()->isPointerTy())
+    return false;
+  unsigned size = 0;
+  for(auto &BB : *F) size += BB.size();
+  return size <= ContextMaxSize;
+}
+
+/// \brief Gives in \p Out the bases \p Call returns in its own context.
+/// The callee's arguments stand for the actual arguments' nodes, which
+/// are solved later with the rest of the interprocedural graph.
+bool OffsetBasedAliasAnalysis::instantiateCall(const CallInst* Call, 
+BaseList &Out) {
+  const Function* F = Call->getCalledFunction();
+  if(!isInstantiable(F)) return false;
+  
+  std::vector<BaseList> actuals(F->arg_size());
+  for(unsigned k = 0; k < actuals.size(); k++) {
+    if(k >= Call->getNumArgOperands()) return false;
+    if(!Call->getArgOperand(k)->getType()->isPointerTy()) continue;
+    OffsetPointer* actual = findOffsetPointer(Call->getArgOperand(k));
+    if(actual == NULL) return false;
+    actuals[k].push_back(std::make_pair(actual, Offset()));
+  }
+  
+  CallString calls(1, Call);
+  return instantiateReturns(F, actuals, Offset(), ContextDepth, calls, Out);
+}
+
+/// \brief Adds to \p Out the bases returned by \p F when its arguments
+/// stand for \p Actuals, shifted by \p Extra. \p Calls is the call string
+/// that reaches F, its last call calls F. Fails when the budget is over or
+/// a returned value is not in the graph.
+bool OffsetBasedAliasAnalysis::instantiateReturns(const Function* F,
+const std::vector<BaseList> &Actuals, const Offset &Extra, unsigned Depth,
+CallString &Calls, BaseList &Out) {
+  if(num_context_clones >= ContextBudget) return false;
+  num_context_clones++;
+  NumContextClones++;
+  
+  for (auto i = inst_begin(F), e = inst_end(F); i != e; i++)
+    if(const ReturnInst* ret = dyn_cast<ReturnInst>(&(*i))) {
+      OffsetPointer* ret_optr = findOffsetPointer(ret->getReturnValue());
+      if(ret_optr == NULL) return false;
+      std::vector<OffsetPointer*> bases;
+      std::vector<Offset> offsets;
+      getBases(ret_optr, bases, offsets);
+      for(unsigned b = 0; b < bases.size(); b++)
+        if(!bindBase(F, bases[b], offsets[b] + Extra, Actuals, Depth, Calls,
+        Out))
+          return false;
+    }
+  return true;
+}
+
+/// \brief Adds to \p Out what the base \p Base of function \p F plus
+/// \p O stands for. F's arguments are replaced by \p Actuals, and calls
+/// to instantiable functions are instantiated while the call string is
+/// shorter than the context depth and the callee is not on it. Heap 
+/// objects F allocates and only returns stand for a clone of their own
+/// in the call string \p Calls. Any other base stands for itself.
+bool OffsetBasedAliasAnalysis::bindBase(const Function* F, OffsetPointer* Base,
+const Offset &O, const std::vector<BaseList> &Actuals, unsigned Depth,
+CallString &Calls, BaseList &Out) {
+  if(Base->pointer_type == OffsetPointer::Arg) {
+    const Argument* arg = cast<Argument>(Base->pointer);
+    if(arg->getParent() == F) {
+      for(auto &a : Actuals[arg->getArgNo()])
+        Out.push_back(std::make_pair(a.first, a.second + O));
+      return true;
+    }
+  }
+  
+  if(Base->pointer_type == OffsetPointer::Call and Depth > 1) {
+    const CallInst* call = cast<CallInst>(Base->pointer);
+    const Function* CF = call->getCalledFunction();
+    bool recursive = false;
+    for(auto c : Calls)
+      if(c->getCalledFunction() == CF) recursive = true;
+    if(isInstantiable(CF) and !recursive) {
+      // the nested call's actual arguments in the outer context
+      std::vector<BaseList> actuals(CF->arg_size());
+      for(unsigned k = 0; k < actuals.size(); k++) {
+        if(k >= call->getNumArgOperands()) return false;
+        if(!call->getArgOperand(k)->getType()->isPointerTy()) continue;
+        OffsetPointer* actual = findOffsetPointer(call->getArgOperand(k));
+        if(actual == NULL) return false;
+        std::vector<OffsetPointer*> bases;
+        std::vector<Offset> offsets;
+        getBases(actual, bases, offsets);
+        for(unsigned b = 0; b < bases.size(); b++)
+          if(!bindBase(F, bases[b], offsets[b], Actuals, 0, Calls, 
+          actuals[k]))
+            return false;
+      }
+      Calls.push_back(call);
+      bool instantiated = 
+        instantiateReturns(CF, actuals, O, Depth - 1, Calls, Out);
+      Calls.pop_back();
+      return instantiated;
+    }
+  }
+  
+  if(HeapCloning and isHeapClonable(F, Base)) {
+    Out.push_back(std::make_pair(getHeapClone(Calls, Base), O));
+    return true;
+  }
+  
+  Out.push_back(std::make_pair(Base, O));
+  return true;
+}
+
+/// \brief Answers whether \p Base is a heap object that \p F allocates
+/// anew at each call: an allocation call of F whose pointer is not
+/// captured but by returning it, so no later call can return it again
+bool OffsetBasedAliasAnalysis::isHeapClonable(const Function* F, 
+const OffsetPointer* Base) const {
+  if(Base->pointer_type != OffsetPointer::Alloc) return false;
+  ImmutableCallSite CS(Base->pointer);
+  if(!CS or CS.getInstruction()->getParent()->getParent() != F) return false;
+  return !PointerMayBeCaptured(Base->pointer, false, true);
+}
+
+/// \brief Returns the clone of the heap object \p Base allocated in the
+/// calling context \p Calls. Clones are bases only, they stand for no
+/// value of the module and so are not in offset_pointers.
+OffsetPointer* OffsetBasedAliasAnalysis::getHeapClone(const CallString &Calls,
+OffsetPointer* Base) {
+  OffsetPointer* &clone = heap_clones[std::make_pair(Calls, Base)];
+  if(clone == NULL) {
+    clone = new OffsetPointer(Base->pointer, OffsetPointer::Alloc);
+    clone->origin = Base->origin;
+    clone->alloc_size_lo = Base->alloc_size_lo;
+    clone->alloc_size_hi = Base->alloc_size_hi;
+    NumHeapClones++;
+  }
+  return clone;
+}
+
+/// \brief Answers whether the address of \p F may reach code the graph does
+/// not see. Its uses are followed through casts, getelementptrs, phis and
+/// selects. Being the callee of a call, an argument of a defined function,
+/// compared or returned keeps it in the graph; anything else, such as a
+/// store, a ptrtoint, a global initializer or an argument of a declaration,
+/// does not. Invokes are not callers the graph sees either.
+static bool mayLeaveGraph(const Function* F) {
+  std::vector<const Value*> work(1, F);
+  std::set<const Value*> seen;
+  while(!work.empty()) {
+    const Value* v = work.back();
+    work.pop_back();
+    if(!seen.insert(v).second) continue;
+    for(auto &u : v->uses()) {
+      const User* user = u.getUser();
+      if(isa<ICmpInst>(user) or isa<ReturnInst>(user)
+      or isa<DbgInfoIntrinsic>(user))
+        continue;
+      if(isa<BitCastInst>(user) or isa<GetElementPtrInst>(user)
+      or isa<PHINode>(user) or isa<SelectInst>(user)
+      or Operator::getOpcode(user) == Instruction::BitCast) {
+        work.push_back(user);
+        continue;
+      }
+      if(const CallInst* call = dyn_cast<CallInst>(user)) {
+        ImmutableCallSite CS(call);
+        if(CS.isCallee(&u)) continue;
+        const Function* callee = CS.getCalledFunction();
+        if(callee != NULL and !callee->isDeclaration()
+        and CS.getArgumentNo(&u) < callee->arg_size())
+          continue;
+      }
+      return true;
+    }
+  }
+  return false;
+}
+
+/// \brief Finds the targets of the indirect calls. The functions a pointer
+/// may hold are those among its bases after intra procedural solving, plus
+/// those held by its argument and call bases: an argument holds what the
+/// actual arguments of the calls to its function hold, and a call result
+/// what the returned values of its targets hold. Sets only grow, so the
+/// iteration stops once none changes. The calls' targets are all known
+/// before the interprocedural edges are added, since solving is not
+/// incremental. A pointer with an unknown base, or that gets its value
+/// from an unknown base or from a declaration, may hold other functions,
+/// and an indirect call through it is unresolved. So may an argument of a
+/// function with callers the graph does not see.
+void OffsetBasedAliasAnalysis::resolveIndirectCalls() {
+  std::map<const OffsetPointer*, std::set<const Function*> > functions;
+  std::set<const OffsetPointer*> incomplete;
+  auto holds = [&](OffsetPointer* P, std::set<const Function*> &Out) {
+    std::vector<OffsetPointer*> bases;
+    std::vector<Offset> offsets;
+    getBases(P, bases, offsets);
+    bool complete = true;
+    for(auto b : bases) {
+      if(b->pointer_type == OffsetPointer::Unk or incomplete.count(b)) 
+        complete = false;
+      if(const Function* F = dyn_cast<Function>(b->pointer)) Out.insert(F);
+      auto f = functions.find(b);
+      if(f != functions.end()) Out.insert(f->second.begin(), f->second.end());
+    }
+    return complete;
+  };
+  
+  call_targets.clear();
+  indirect_callers.clear();
+  unresolved_calls.clear();
+  exposed_functions.clear();
+  for(auto p : offset_pointers)
+    if(p.second->pointer_type == OffsetPointer::Arg) {
+      const Function* F = cast<Argument>(p.first)->getParent();
+      if(!exposed_functions.count(F) and mayLeaveGraph(F))
+        exposed_functions.insert(F);
+    }
+  bool changed = true;
+  while(changed) {
+    changed = false;
+    for(auto call : indirect_calls) {
+      OffsetPointer* callee = findOffsetPointer(call->getCalledValue());
+      std::set<const Function*> &targets = call_targets[call];
+      unsigned before = targets.size();
+      bool complete = callee != NULL and holds(callee, targets);
+      for(auto T : targets)
+        if(T->isDeclaration()) complete = false;
+      if(targets.size() != before) changed = true;
+      if(!complete and unresolved_calls.insert(call).second) changed = true;
+    }
+    
+    indirect_callers.clear();
+    for(auto &t : call_targets)
+      for(auto F : t.second)
+        indirect_callers[F].push_back(t.first);
+    
+    for(auto p : offset_pointers) {
+      OffsetPointer* op = p.second;
+      std::set<const Function*> held;
+      bool complete = true;
+      if(op->pointer_type == OffsetPointer::Arg) {
+        const Argument* arg = cast<Argument>(op->pointer);
+        const Function* F = arg->getParent();
+        if(hasUnseenCallers(F)) complete = false;
+        std::vector<const CallInst*> callers = getIndirectCallers(F);
+        for(auto u = F->user_begin(), ue = F->user_end(); u != ue; u++)
+          if(const CallInst* caller = dyn_cast<CallInst>(*u))
+            if(caller->getCalledFunction() == F)
+              callers.push_back(caller);
+        for(auto caller : callers) {
+          if(arg->getArgNo() >= caller->getNumArgOperands()) continue;
+          OffsetPointer* actual = 
+            findOffsetPointer(caller->getArgOperand(arg->getArgNo()));
+          if(actual == NULL or !holds(actual, held)) complete = false;
+        }
+      }
+      else if(op->pointer_type == OffsetPointer::Call) {
+        const CallInst* call = cast<CallInst>(op->pointer);
+        std::set<const Function*> targets;
+        if(const Function* CF = call->getCalledFunction()) targets.insert(CF);
+        else {
+          targets = getCallTargets(call);
+          if(hasUnresolvedTargets(call)) complete = false;
+        }
+        for(auto T : targets) {
+          if(T->isDeclaration()) complete = false;
+          for (auto i = inst_begin(T), e = inst_end(T); i != e; i++)
+            if(const ReturnInst* ret = dyn_cast<ReturnInst>(&(*i)))
+              if(ret->getReturnValue() != NULL)
+                if(OffsetPointer* r = findOffsetPointer(ret->getReturnValue()))
+                  if(!holds(r, held)) complete = false;
+        }
+      }
+      else continue;
+      
+      std::set<const Function*> &fs = functions[op];
+      unsigned before = fs.size();
+      fs.insert(held.begin(), held.end());
+      if(fs.size() != before) changed = true;
+      if(!complete and incomplete.insert(op).second) changed = true;
+    }
+  }
+  
+  DEBUG_WITH_TYPE("indirect", 
+    for(auto &t : call_targets) {
+      errs() << *t.first << " ->";
+      for(auto F : t.second) errs() << " " << F->getName();
+      if(unresolved_calls.count(t.first)) errs() << " ?";
+      errs() << "\n";
+    });
+}
+
+/// \brief Functions an indirect call may reach, as resolved by the graph
+const std::set<const Function*>& OffsetBasedAliasAnalysis::getCallTargets(
+const CallInst* Call) const {
+  static const std::set<const Function*> none;
+  auto t = call_targets.find(Call);
+  if(t == call_targets.end()) return none;
+  return t->second;
+}
+
+/// \brief Indirect calls that may reach \p F
+const std::vector<const CallInst*>& 
+OffsetBasedAliasAnalysis::getIndirectCallers(const Function* F) const {
+  static const std::vector<const CallInst*> none;
+  auto c = indirect_callers.find(F);
+  if(c == indirect_callers.end()) return none;
+  return c->second;
+}
+
+/// \brief Answers whether the indirect call \p Call may reach a function
+/// that is not among its targets or whose returns are not in the graph.
+/// Its result is then left unknown.
+bool OffsetBasedAliasAnalysis::hasUnresolvedTargets(const CallInst* Call) 
+const {
+  return unresolved_calls.count(Call);
+}
+
+/// \brief Answers whether \p F may be called by code the graph does not
+/// see: its address may leave the graph, or it is address taken and some
+/// indirect call is unresolved, so that call may reach it. Its arguments
+/// are then left unknown.
+bool OffsetBasedAliasAnalysis::hasUnseenCallers(const Function* F) const {
+  if(exposed_functions.count(F)) return true;
+  return !unresolved_calls.empty() and F->hasAddressTaken();
+}
+
+/// \brief Answers whether the argument \p A is an object of its own while
+/// its function runs. A byval argument is a copy made for the call, and a
+/// noalias one is not reached by other pointers while the function runs.
+/// In -inter mode noalias arguments take the bases of the actual arguments
+/// instead, as those outlive the call.
+bool OffsetBasedAliasAnalysis::isUniqueArgument(const Argument* A) const {
+  return A->hasByValAttr() or (A->hasNoAliasAttr() and !Interprocedural);
+}
+
 /// \brief Function that prints the dependence graph in DOT format
 void OffsetBasedAliasAnalysis::printDOT(Module &M, std::string Stage) { 
   std::string name = M.getModuleIdentifier();
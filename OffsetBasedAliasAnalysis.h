@@ -12,26 +12,63 @@
 #ifndef __OFFSET_BASED_ALIAS_ANALYSIS_H__
 #define __OFFSET_BASED_ALIAS_ANALYSIS_H__
 
+// local includes
+#include "LocalTrees.h"
+#include "Offset.h"
 // LLVM's includes
 #include "llvm/Pass.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/BitVector.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/Analysis/AliasAnalysis.h"
 // libc's includes
 #include <map>
 #include <set>
 #include <deque>
+#include <vector>
 
 namespace llvm
 {
 
 /// Forward declarations
+class Address;
+class Argument;
+class Constant;
 class OffsetPointer;
+class DifferenceBounds;
+
+/// \brief Packed bit matrix of an all pairs alias query. Bit (i, j) is set 
+/// when locations i and j may alias.
+class AliasMatrix {
+public:
+  AliasMatrix(unsigned N) : n(N), bits(N*N) {}
+  unsigned size() const { return n; }
+  bool mayAlias(unsigned I, unsigned J) const { return bits.test(I*n + J); }
+  void setMayAlias(unsigned I, unsigned J) {
+    bits.set(I*n + J);
+    bits.set(J*n + I);
+  }
+private:
+  unsigned n;
+  BitVector bits;
+};
+
+/// \brief Distance in bytes between two pointers. When Known, B - A is
+/// within [Min, Max].
+struct OffsetDistance {
+  bool Known;
+  int64_t Min, Max;
+};
 
 class OffsetBasedAliasAnalysis : public ModulePass, public AliasAnalysis {
 public:
   
   /// LLVM framework methods and atributes
   static char ID; // Class identification, replacement for typeinfo
-  OffsetBasedAliasAnalysis() : ModulePass(ID){}
+  OffsetBasedAliasAnalysis() : ModulePass(ID), difference_bounds(NULL),
+    num_base_ids(0), frozen(false), num_context_clones(0) {}
+  /// \brief Reports the query statistics requested on the command line
+  ~OffsetBasedAliasAnalysis();
   void getAnalysisUsage(AnalysisUsage &AU) const override;
   bool runOnModule(Module &M) override;
   
@@ -39,6 +76,20 @@ public:
   AliasResult alias(const MemoryLocation &LocA,
     const MemoryLocation &LocB) override;
   bool pointsToConstantMemory(const MemoryLocation &Loc, bool OrLocal) override;
+  /// Do not hide the other getModRefInfo overloads
+  using AliasAnalysis::getModRefInfo;
+  /// \brief Whether the call \p CS may read or write \p Loc, using the
+  /// callee's summary or the operands of a memory intrinsic
+  ModRefResult getModRefInfo(ImmutableCallSite CS,
+    const MemoryLocation &Loc) override;
+  /// \brief Alias relation of every pair of \p Locs, cheaper than calling
+  /// alias for each pair. With \p BasesOnly only the facts that hold for 
+  /// any offsets are used.
+  AliasMatrix aliasMatrix(ArrayRef<MemoryLocation> Locs, 
+    bool BasesOnly = false);
+  /// \brief Bounds of \p B - \p A in bytes when both pointers are known
+  /// to point into the same object
+  OffsetDistance getOffsetDistance(const Value* A, const Value* B) const;
   /// getAdjustedAnalysisPointer - This method is used when a pass implements
   /// an analysis interface through multiple inheritance.  If needed, it
   /// should override this to adjust the this pointer as needed for the
@@ -49,25 +100,110 @@ public:
     return this;
   }
   
+  /// \brief Functions an indirect call may reach, as resolved by the graph
+  ///  in -inter mode
+  const std::set<const Function*>& getCallTargets(const CallInst* Call) const;
+  /// \brief Indirect calls that may reach \p F
+  const std::vector<const CallInst*>& getIndirectCallers(const Function* F)
+    const;
+  /// \brief Answers whether the indirect call \p Call may reach a function
+  ///  that is not among its targets or whose returns are not in the graph
+  bool hasUnresolvedTargets(const CallInst* Call) const;
+  /// \brief Answers whether \p F may be called by code the graph does not
+  ///  see, so its arguments' values are not all known
+  bool hasUnseenCallers(const Function* F) const;
+  /// \brief Answers whether the argument \p A is an object of its own
+  ///  while its function runs, and so a base of the graph
+  bool isUniqueArgument(const Argument* A) const;
+  
   /// \brief Function that returns the offset pointer corresponding
-  ///  to the value given
+  ///  to the value given. Once the analysis is frozen values outside the
+  ///  graph give NULL instead of a new pointer.
   OffsetPointer* getOffsetPointer(const Value*);
   
 private:
+  /// \brief Memory a function may read or write: the positions of the
+  /// arguments it accesses through, the bases outside its frame and
+  /// whether it accesses memory the graph cannot name
+  struct ModRefSummary {
+    std::set<unsigned> mod_args, ref_args;
+    std::set<const OffsetPointer*> mod_bases, ref_bases;
+    bool mod_unknown, ref_unknown;
+    ModRefSummary() : mod_unknown(false), ref_unknown(false) {}
+    unsigned size() const {
+      return mod_args.size() + ref_args.size() + mod_bases.size() 
+        + ref_bases.size() + mod_unknown + ref_unknown;
+    }
+  };
   /// \brief map that contains all the pointers represented
   std::map<const Value*, OffsetPointer* > offset_pointers;
   std::set<const Value*> all_pointers;
   std::set<const StoreInst*> relevant_stores;
+  /// \brief all loads and stores of the module, in program order
+  std::vector<const LoadInst*> all_loads;
+  std::vector<const StoreInst*> all_stores;
+  /// \brief loads whose addresses come from the stores they may read
+  std::set<const LoadInst*> modeled_loads;
+  /// \brief Scalars of the initializers of the globals whose contents are
+  /// known, as (byte offset, value) pairs
+  std::map<const OffsetPointer*, 
+    std::vector<std::pair<int64_t, const Constant*> > > global_contents;
+  /// \brief calls whose callee is not a function
+  std::vector<const CallInst*> indirect_calls;
+  /// \brief functions each indirect call may reach and its inverse
+  std::map<const CallInst*, std::set<const Function*> > call_targets;
+  std::map<const Function*, std::vector<const CallInst*> > indirect_callers;
+  /// \brief indirect calls that may reach functions the graph does not see
+  std::set<const CallInst*> unresolved_calls;
+  /// \brief functions whose address may reach code the graph does not see
+  std::set<const Function*> exposed_functions;
   /// \brief map that stores whether a function returns a local alloc or not
   std::map<const Function*, bool> allocFunctions;
+  /// \brief Local trees of the dependence graph before solving
+  LocalTrees local_trees;
+  /// \brief Relational constraints between pointers of the same function
+  DifferenceBounds* difference_bounds;
+  /// \brief Number of base identifiers given so far, plus one
+  int64_t num_base_ids;
+  /// \brief Mod/Ref summaries of the functions defined in the module
+  std::map<const Function*, ModRefSummary> modref_summaries;
+  /// \brief Read only index of the solved graph used by the queries, so
+  /// they can run concurrently
+  DenseMap<const Value*, OffsetPointer*> query_index;
+  /// \brief Whether the graph is solved and the queries use query_index
+  bool frozen;
+  /// \brief Bases, with their offsets, that a value stands for in some
+  /// calling context
+  typedef std::vector<std::pair<OffsetPointer*, Offset> > BaseList;
+  /// \brief Number of callee summaries instantiated at call sites
+  unsigned num_context_clones;
+  /// \brief Calls that lead to an instantiated callee, outermost first
+  typedef std::vector<const CallInst*> CallString;
+  /// \brief Clones of the heap objects by calling context
+  std::map<std::pair<CallString, const OffsetPointer*>, OffsetPointer*> 
+    heap_clones;
   /// \brief Counts how many dot graphs were printed
   unsigned int dotNum;
+  /// \brief Answers the alias query once both offset pointers are known
+  AliasResult aliasPointers(OffsetPointer* op1, const MemoryLocation &LocA,
+    OffsetPointer* op2, const MemoryLocation &LocB);
+  /// \brief Answers true if the addresses \p I of \p op1 and \p J of \p op2
+  /// are on objects that are never the same, setting the rules that apply
+  bool disjointBases(const OffsetPointer* op1, const Address* I,
+    const OffsetPointer* op2, const Address* J, bool &argument_rule,
+    bool &escape_rule, bool &bases_rule) const;
+  /// \brief Answers true if \p op1 and \p op2 never point into the same
+  /// object, from their bases alone
+  bool disjointObjects(const OffsetPointer* op1, const OffsetPointer* op2) 
+    const;
   /// \brief Gather all pointers from the module
   void gatherPointers(Module &M);
   /// \brief Builds the dependence graph using an intra procedural frame
   void buildIntraProceduralDepGraph();
   /// \brief Obtains narrowing information from the module
   void getNarrowingInfo();
+  /// \brief Builds the relational constraints of each function
+  void buildDifferenceBounds(Module &M);
   /// \brief DFS based on color 
   void DFS_visit_t(OffsetPointer* u, std::deque<OffsetPointer*>* dqp);
   /// \brief DFS visit for calculating scc
@@ -80,18 +216,103 @@ private:
   void resolveSCCs(std::map<int,std::pair<OffsetPointer*, int> > sccs);
   /// \brief Resolves the whole graph
   void resolveWholeGraph();
+  /// \brief Gives loads from tracked objects the addresses of the pointers
+  ///  stored to them, in bounded rounds that solve the graph again
+  void modelMemory();
+  /// \brief A single round of modelMemory, answers whether any load was
+  ///  modeled
+  bool modelMemoryRound();
+  /// \brief Records the initializers of the constant and internal globals
+  void seedGlobalContents();
+  /// \brief Returns the offset pointer of the constant \p C, adding it and
+  ///  its operands to the graph if they are not there yet
+  OffsetPointer* getConstantPointer(const Constant* C);
+  /// \brief Adds to \p Values the pointers \p L may read from the 
+  ///  initializer of \p G at offset \p O, answers false if it may read 
+  ///  something else
+  bool readInitializer(const LoadInst* L, const OffsetPointer* G, 
+    const Offset &O, std::set<OffsetPointer*> &Values);
+  /// \brief Answers whether the accesses through \p A and \p B are to
+  ///  different fields of the struct elements of object \p O
+  bool differentFields(const Value* A, const Value* B, 
+    const OffsetPointer* O) const;
+  /// \brief Answers whether \p U, a user of \p V, keeps every pointer to
+  ///  the object of \p Derived in the graph
+  bool isTrackedUse(const User* U, const Value* V, 
+    const std::set<OffsetPointer*> &Derived) const;
+  /// \brief Marks the allocs that pointers outside the graph may reach
+  void findEscapingObjects();
+  /// \brief Answers whether \p U, a user of \p V, keeps the object of
+  ///  \p Derived from escaping
+  bool isLocalUse(const User* U, const Value* V,
+    const std::set<OffsetPointer*> &Derived) const;
+  /// \brief Forgets the allocation size of the bases that are reallocated
+  void dropReallocatedSizes();
   /// \brief Applies the windening operators present in the graph
   void applyWidening();
   /// \brief Applies the narrowing operators present in the graph
   void applyNarrowing();
-  /// \brief Analyzes the function F to verify if it returns a local alloc
-  void analyzeFunction(const Function* F);
+  /// \brief Gives the bases identifiers and builds the pointers' triples
+  void buildAddressTriples();
+  /// \brief Partitions the pointers into may alias classes
+  void buildAliasClasses();
+  /// \brief Computes the Mod/Ref summaries of all functions up to a fixed
+  /// point over the calls between them
+  void buildModRefSummaries(Module &M);
+  /// \brief Adds to \p S the effect of instruction \p I of function \p F
+  void summarizeInstruction(ModRefSummary &S, const Function* F,
+    const Instruction* I);
+  /// \brief Adds to \p S an access of function \p F through \p P
+  void summarizeAccess(ModRefSummary &S, const Function* F, const Value* P,
+    bool Mod);
+  /// \brief Answers whether a call \p CS whose callee accesses \p Args,
+  /// \p Bases or unknown memory may access the memory of \p Loc
+  bool callMayAccess(ImmutableCallSite CS, const std::set<unsigned> &Args,
+    const std::set<const OffsetPointer*> &Bases, bool Unknown, 
+    const OffsetPointer* Loc);
+  /// \brief Answers whether \p A and \p B may have a base in common,
+  /// regardless of offsets
+  bool mayShareBase(const OffsetPointer* A, const OffsetPointer* B) const;
+  /// \brief Returns the offset pointer of \p V if it is in the graph,
+  /// without adding it
+  OffsetPointer* findOffsetPointer(const Value* V) const;
+  /// \brief Builds the query index and stops the graph from changing
+  void freeze();
+  /// \brief Finds the functions that return fresh allocations, visiting
+  /// the call graph's SCCs bottom up
+  void analyzeCallGraph();
+  /// \brief Answers whether F returns a fresh allocation given what is
+  /// known of the other functions
+  bool analyzeFunction(const Function* F);
   /// \brief Updates the call insts to allocs if the called function returns
   ///  a local Alloc
   void updateCalls();
   /// \brief Adds addresses to arguments and calls to make the dependence graph
   ///  interprocedural
   void addInterProceduralEdges(); 
+  /// \brief Finds the targets of the indirect calls from the function
+  ///  pointers in the graph, to a fixed point
+  void resolveIndirectCalls();
+  /// \brief Answers whether calls to \p F may instantiate its summary
+  bool isInstantiable(const Function* F) const;
+  /// \brief Gives in \p Out the bases \p Call returns in its own context,
+  /// answers false if the callee's summary cannot be instantiated
+  bool instantiateCall(const CallInst* Call, BaseList &Out);
+  /// \brief Adds to \p Out the bases returned by \p F when its arguments
+  /// stand for \p Actuals, shifted by \p Extra
+  bool instantiateReturns(const Function* F, 
+    const std::vector<BaseList> &Actuals, const Offset &Extra, unsigned Depth,
+    CallString &Calls, BaseList &Out);
+  /// \brief Adds to \p Out what the base \p Base of function \p F plus
+  /// \p O stands for when F's arguments stand for \p Actuals
+  bool bindBase(const Function* F, OffsetPointer* Base, const Offset &O,
+    const std::vector<BaseList> &Actuals, unsigned Depth,
+    CallString &Calls, BaseList &Out);
+  /// \brief Answers whether each call to \p F allocates a new \p Base
+  bool isHeapClonable(const Function* F, const OffsetPointer* Base) const;
+  /// \brief Returns the clone of the heap object \p Base in the calling
+  /// context \p Calls
+  OffsetPointer* getHeapClone(const CallString &Calls, OffsetPointer* Base);
   /// \brief Function that prints the dependence graph in DOT format
   void printDOT(Module &M, std::string Stage);
 };
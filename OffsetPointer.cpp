@@ -17,10 +17,15 @@
 #include "Address.h"
 #include "OffsetBasedAliasAnalysis.h"
 #include "Offset.h"
+#include "RAOffset.h"
 // llvm includes
+#include "llvm/Analysis/MemoryBuiltins.h"
+#include "llvm/Analysis/TargetLibraryInfo.h"
+#include "llvm/IR/CallSite.h"
 #include "llvm/IR/Value.h"
 #include "llvm/IR/Type.h"
 #include "llvm/IR/Constants.h"
+#include "llvm/IR/DataLayout.h"
 #include "llvm/IR/Argument.h"
 #include "llvm/IR/Function.h"
 #include "llvm/IR/Operator.h"
@@ -40,6 +45,17 @@ OffsetPointer::OffsetPointer(const Value* V) : pointer(V) {
   assert(V->getType()->isPointerTy() && "Tried to build non pointer.");
   
   pointer_type = PointerTypes::Unk;  
+  base_id = 0;
+  local_root = local_parent = NULL;
+  local_depth = local_state = 0;
+  euler_first = 0;
+  base_signature = 0;
+  unk_signature = 0;
+  arg_signature = false;
+  alias_class = -1;
+  alloc_size_lo = alloc_size_hi = -1;
+  escapes = true;
+  origin = this;
 }
 
 /// \brief Constructor that recieves a simple Value* and a Type
@@ -48,6 +64,17 @@ OffsetPointer::OffsetPointer(const Value* V, PointerTypes Pt) : pointer(V) {
   assert(V->getType()->isPointerTy() && "Tried to build non pointer.");
   
   pointer_type = Pt;  
+  base_id = 0;
+  local_root = local_parent = NULL;
+  local_depth = local_state = 0;
+  euler_first = 0;
+  base_signature = 0;
+  unk_signature = 0;
+  arg_signature = false;
+  alias_class = -1;
+  alloc_size_lo = alloc_size_hi = -1;
+  escapes = true;
+  origin = this;
 }
 
 /// \brief Returns the LLVM's Value to which the object represents
@@ -83,6 +110,36 @@ std::set<Address *>::iterator OffsetPointer::bases_end() const {
   return bases.end();
 }
 
+/// \brief Returns whether the size of the allocated object is known
+bool OffsetPointer::hasAllocSize() const { 
+  return pointer_type == Alloc and alloc_size_hi >= 0;
+}
+
+/// \brief Returns the largest size in bytes the allocated object may have
+int64_t OffsetPointer::getAllocSizeUpper() const { return alloc_size_hi; }
+
+/// \brief Returns whether pointers outside the graph may reach the object
+bool OffsetPointer::mayEscape() const { return escapes; }
+
+/// \brief Records the allocated size as \p Count elements of \p Scale bytes.
+/// Symbolic counts use the bounds given by range analysis.
+void OffsetPointer::recordAllocSize(const Value* Count, uint64_t Scale) {
+  int64_t lo, hi;
+  if(const ConstantInt* c = dyn_cast<ConstantInt>(Count)) {
+    if(c->getValue().getActiveBits() > 62) return;
+    lo = hi = (int64_t) c->getZExtValue();
+  }
+  else if(!RAOffset::getValueBounds(Count, lo, hi)) return;
+  
+  if(hi < 0) return;
+  if(lo < 0) lo = 0;
+  if(Scale > (uint64_t) INT64_MAX or (Scale > 0 and 
+  (uint64_t) hi > (uint64_t) INT64_MAX / Scale))
+    return;
+  alloc_size_lo = lo * (int64_t) Scale;
+  alloc_size_hi = hi * (int64_t) Scale;
+}
+
 /// \brief Sets which kind of pointer in the graph this object has
 void OffsetPointer::setPointerType(OffsetPointer::PointerTypes Pt) { 
   pointer_type = Pt; 
@@ -102,6 +159,8 @@ void OffsetPointer::print() const {
     errs() << "Continuous\n";
   else if(pointer_type == OffsetPointer::Null)
     errs() << "Null\n";
+  if(hasAllocSize())
+    errs() << "Size: [" << alloc_size_lo << ", " << alloc_size_hi << "]\n";
   
   errs() << "{";
   bool notFirst = false;
@@ -120,32 +179,47 @@ Analysis){
   // Global variables in LLVM are pointers by definition with their own alloc
   if(isa<const GlobalVariable>(*pointer)) { pointer_type = Global; }
   else if(const Argument* p = dyn_cast<Argument>(pointer)) { 
-    if(p->getName().equals("argv")) { pointer_type = Alloc; }
+    if(Analysis->isUniqueArgument(p)) { pointer_type = Alloc; }
     else { pointer_type = Arg; }
   }
-  else if(isa<const AllocaInst>(*pointer)) { 
+  else if(const AllocaInst* p = dyn_cast<AllocaInst>(pointer)) { 
     pointer_type = Alloc;
+    const DataLayout* DL = Analysis->getDataLayout();
+    if(DL != NULL)
+      recordAllocSize(p->getArraySize(), 
+        DL->getTypeAllocSize(p->getAllocatedType()));
   }
-  else if(const CallInst* p = dyn_cast<CallInst>(pointer)) { 
-    Function* CF = p->getCalledFunction();
-    if(CF) {
-      if(strcmp( CF->getName().data(), "malloc") == 0) { 
-        pointer_type = Alloc; 
-      }
-      else if(strcmp( CF->getName().data(), "calloc") == 0) { 
-        pointer_type = Alloc; 
-      }
-      else if(strcmp( CF->getName().data(), "realloc") == 0)
-      {
-        /// realloc is of the same name as it's first argument
-        pointer_type = Cont;
-        const Value* base_ptr_value = p->getOperand(0);
-        OffsetPointer* base_ptr = Analysis->getOffsetPointer(base_ptr_value);
-        new Address(this, base_ptr, Offset());
-      }
-      else {
-        pointer_type = Call;
-      }
+  else if(isa<CallInst>(pointer) or isa<InvokeInst>(pointer)) {
+    ImmutableCallSite CS(pointer);
+    const TargetLibraryInfo* TLI = Analysis->getTargetLibraryInfo();
+    if(isReallocLikeFn(pointer, TLI, true)) {
+      /// realloc is of the same name as it's first argument
+      pointer_type = Cont;
+      const Value* base_ptr_value = CS.getArgument(0);
+      OffsetPointer* base_ptr = Analysis->getOffsetPointer(base_ptr_value);
+      new Address(this, base_ptr, Offset());
+    }
+    else if(isCallocLikeFn(pointer, TLI, true)) { 
+      pointer_type = Alloc; 
+      const Value* num = CS.getArgument(0);
+      const Value* size = CS.getArgument(1);
+      if(const ConstantInt* c = dyn_cast<ConstantInt>(size))
+        recordAllocSize(num, c->getZExtValue());
+      else if(const ConstantInt* c = dyn_cast<ConstantInt>(num))
+        recordAllocSize(size, c->getZExtValue());
+    }
+    else if(isMallocLikeFn(pointer, TLI, true)) { 
+      /// malloc, valloc and the operator new family take the size first
+      pointer_type = Alloc; 
+      recordAllocSize(CS.getArgument(0), 1);
+    }
+    else if(isAllocationFn(pointer, TLI, true) or isNoAliasCall(pointer)) {
+      /// strdup and the like, and functions whose return is noalias
+      pointer_type = Alloc;
+    }
+    else if(isa<CallInst>(pointer)) {
+      /// indirect calls are resolved with the graph in -inter mode
+      pointer_type = Call;
     }
   }
   else if(const BitCastInst* p = dyn_cast<BitCastInst>(pointer)) { 
@@ -206,35 +280,43 @@ void OffsetPointer::addInterProceduralAddresses(OffsetBasedAliasAnalysis*
 Analysis){
   if(const Argument* p = dyn_cast<Argument>(pointer)) {
     const Function* F = p->getParent();
-    //Go through all the uses of the argument's function, the calls are
-    // the addresses bases
-    for(auto ui = F->user_begin(), ue = F->user_end(); ui != ue; ui++) {
-      const User* u = *ui;
-      if(const CallInst* caller = dyn_cast<CallInst>(u)) {
-        int anum = caller->getNumArgOperands();
-        int ano = p->getArgNo();
-        if(ano <= anum) {
-          // create address
-          OffsetPointer* base = Analysis->getOffsetPointer
-            (caller->getArgOperand(ano));
-          if(base != NULL) 
-            new Address(this, base, Offset());
-        } else {
-          /// TODO: support standard values in cases where the argument
-          /// has a standard value and does not appear in function call
-          DEBUG_WITH_TYPE("errors",
-            errs() << "!: ERROR (Not enough arguments):\n");
-          DEBUG_WITH_TYPE("errors", errs() << *p << " " << ano << "\n");
-          DEBUG_WITH_TYPE("errors", errs() << *u << "\n");
-          pointer_type = Unk;
-          addresses.clear();
-          return;
-        }
+    //Go through all the calls to the argument's function, direct or 
+    // resolved from the graph, the actual arguments are the addresses bases
+    std::vector<const CallInst*> callers;
+    for(auto ui = F->user_begin(), ue = F->user_end(); ui != ue; ui++)
+      if(const CallInst* caller = dyn_cast<CallInst>(*ui))
+        if(caller->getCalledFunction() == F)
+          callers.push_back(caller);
+    const std::vector<const CallInst*>& indirect = 
+      Analysis->getIndirectCallers(F);
+    callers.insert(callers.end(), indirect.begin(), indirect.end());
+    for(auto caller : callers) {
+      int anum = caller->getNumArgOperands();
+      int ano = p->getArgNo();
+      if(ano < anum) {
+        // create address
+        OffsetPointer* base = Analysis->getOffsetPointer
+          (caller->getArgOperand(ano));
+        if(base != NULL) 
+          new Address(this, base, Offset());
+      } else {
+        /// TODO: support standard values in cases where the argument
+        /// has a standard value and does not appear in function call
+        DEBUG_WITH_TYPE("errors",
+          errs() << "!: ERROR (Not enough arguments):\n");
+        DEBUG_WITH_TYPE("errors", errs() << *p << " " << ano << "\n");
+        DEBUG_WITH_TYPE("errors", errs() << *caller << "\n");
+        pointer_type = Unk;
+        addresses.clear();
+        return;
       }
     }
   } else if (const CallInst* p = dyn_cast<CallInst>(pointer)){
-    Function* CF = p->getCalledFunction();
-    if(CF) {
+    std::set<const Function*> targets;
+    if(const Function* CF = p->getCalledFunction()) targets.insert(CF);
+    else targets = Analysis->getCallTargets(p);
+    for(auto CF : targets) {
+      if(!CF->getReturnType()->isPointerTy()) continue;
       for (auto i = inst_begin(CF), e = inst_end(CF); i != e; i++)
         if(isa<const ReturnInst>(*i)) {
             /// create address
@@ -249,42 +331,3 @@ Analysis){
     }
   }
 }
-
-/// \brief Function that finds the pointer's path to the root of it's local
-/// tree.
-/// TODO: Optimize function to take advantage of topological ordering.
-void OffsetPointer::getPathToRoot() {
-  OffsetPointer* current = this;
-  int index = 0;
-  Offset offset;
-  while(true) {
-    path_to_root[current] = std::pair<int, Offset>(index, offset);
-    if(current->addresses.size() == 1) {
-      Address* addr = *(current->addresses.begin());
-      current = addr->getBase();
-      if(path_to_root.count(current)) {
-        //This means that the local tree is actually a lonely loop
-      	// so the local tree's root will be the pointer with the highest address
-      	OffsetPointer* root = NULL;
-      	for(auto i : path_to_root){
-      		if(root < i.first) root = i.first;
-      	}
-      	local_root = root;
-      	break;
-      }
-      index++;
-      offset = offset + addr->getOffset();
-    } else {
-      local_root = current;
-      break;
-    }
-  }
-}
-
-
-
-
-
-
-
-
@@ -14,6 +14,7 @@
 #define __OFFSET_POINTER_H__
 
 // Project's includes
+#include "AddressTriples.h"
 #include "Offset.h"
 // llvm's includes
 // libc includes
@@ -34,6 +35,7 @@ class OffsetPointer {
   // pointers bases and addresses are updated.
   friend class Address;
   friend class Offset;
+  friend class LocalTrees;
   friend class OffsetBasedAliasAnalysis;
 
 public:
@@ -55,6 +57,13 @@ public:
   std::set<Address *>::iterator bases_begin() const;
   std::set<Address *>::iterator bases_end() const;
 
+  /// \brief Returns whether the size of the allocated object is known
+  bool hasAllocSize() const;
+  /// \brief Returns the largest size in bytes the allocated object may have
+  int64_t getAllocSizeUpper() const;
+  /// \brief Returns whether pointers outside the graph may reach the object
+  bool mayEscape() const;
+
   // Functions that set the object's information
   void setPointerType(PointerTypes Pt);
 
@@ -65,20 +74,49 @@ public:
   ///  this is the most important feature of this class.
   void addIntraProceduralAddresses(OffsetBasedAliasAnalysis* Analysis);
   void addInterProceduralAddresses(OffsetBasedAliasAnalysis* Analysis);
-  
-  void getPathToRoot();
 
 private:
+  /// \brief Records the allocated size as \p Count elements of \p Scale bytes
+  void recordAllocSize(const Value* Count, uint64_t Scale);
+
   const Value* const pointer;
   std::set<Address* > addresses;
   std::set<Address* > bases;
   PointerTypes pointer_type;
+  // bounds of the allocated object's size in bytes, negative if unknown
+  int64_t alloc_size_lo;
+  int64_t alloc_size_hi;
+  // whether pointers outside the graph may reach the object, see 
+  // OffsetBasedAliasAnalysis::findEscapingObjects
+  bool escapes;
+  // the alloc this one is a heap clone of, itself if it is not a clone
+  OffsetPointer* origin;
   // members that help topological ordering and scc finding
   int color;
   int scc;
-  // function and structures for the local analysis
+  // members of the local tree, see LocalTrees
   OffsetPointer *local_root;
-  std::map<OffsetPointer *, std::pair<int, Offset>> path_to_root;
+  OffsetPointer *local_parent;
+  int local_depth;
+  int local_state;
+  unsigned euler_first;
+  // offset from the parent and from the root of the local tree
+  Offset local_edge;
+  Offset local_offset;
+  // identifier given to the pointer when it is some address' base, negative
+  // for unknown pointers
+  int64_t base_id;
+  // the solved addresses as (base, lo, hi) triples
+  AddressTriples triples;
+  // may alias class of pointers without unknown bases, negative if none
+  int alias_class;
+  // bloom signature of the known bases' identifiers
+  uint64_t base_signature;
+  // identifier of the only unknown base, 0 if there is none and INT64_MIN
+  // if there are several
+  int64_t unk_signature;
+  // whether the pointer is an argument or some address has the argument flag
+  bool arg_signature;
   
 };
 }
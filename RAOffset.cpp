@@ -23,6 +23,15 @@
 using namespace llvm;
 
 extern APInt Zero;
+extern APInt Min;
+extern APInt Max;
+
+// Not a default representation, it keeps no offset yet and only brings
+// range analysis in for getValueBounds
+static RegisterOffsetRepresentation<RAOffset> X("range",
+  "Offsets as integer ranges given by range analysis", 10, false);
+
+IntraProceduralRA<Cousot>* RAOffset::ra = NULL;
 
 RAOffset::RAOffset() : r(Zero, Zero) { }
 
@@ -32,31 +41,55 @@ RAOffset::RAOffset(const Value* Pointer, const Value* Base) { }
 /// \brief Destructor 
 RAOffset::~RAOffset() { }
 
-/// \brief Returns a copy of the represented offset
-RAOffset* RAOffset::copy() { return NULL; }
+/// \brief Returns a copy of the represented offset. Every offset is the
+/// unknown one for now.
+RAOffset* RAOffset::copy() { return new RAOffset(); }
 
 /// \brief Adds two offsets of the respective representation
-RAOffset* RAOffset::add(OffsetRepresentation* Other) { return NULL; }
+RAOffset* RAOffset::add(OffsetRepresentation* Other) { return new RAOffset(); }
 
-/// \brief Answers true if two offsets are disjoints
-bool RAOffset::disjoint(OffsetRepresentation* Other) { return false; }
+/// \brief Answers true if the accessed byte intervals are disjoint
+bool RAOffset::disjoint(OffsetRepresentation* Other, uint64_t Size, 
+uint64_t OtherSize) { 
+  return false; 
+}
 
 /// \brief Narrows the offset of the respective representation
 RAOffset* RAOffset::narrow(CmpInst::Predicate Cmp, OffsetRepresentation* Other){
-  return NULL;
+  return this;
 }
 
 /// \brief Widens the offset of the respective representation, Before and 
 ///   After are given so its possible to calculate direction of growth.
 RAOffset* RAOffset::widen(OffsetRepresentation* Before,
-OffsetRepresentation* After) { return NULL; }
+OffsetRepresentation* After) { return this; }
 
 /// \brief Prints the offset representation
 void RAOffset::print() { }
 /// \brief Prints the offset to a file
 void RAOffset::print(raw_fd_ostream& fs) { }
 
+/// \brief Adds range analysis to the required analyses
+void RAOffset::getAnalysisUsage(AnalysisUsage &AU) {
+  AU.addRequired<IntraProceduralRA<Cousot> >();
+}
 
+/// \brief Fetches the range analysis from obaa
 void RAOffset::initialization(OffsetBasedAliasAnalysis* Analysis) {
   ra = &(Analysis->getAnalysis<IntraProceduralRA<Cousot> >());
 }
+
+/// \brief Gives the bounds range analysis found for the integer \p V.
+/// Returns false if range analysis is not in use or \p V is unbounded.
+bool RAOffset::getValueBounds(const Value* V, int64_t& Lo, int64_t& Hi) {
+  if(ra == NULL) return false;
+  Range range = ra->getRange(V);
+  if(range.isUnknown()) return false;
+  const APInt& l = range.getLower();
+  const APInt& u = range.getUpper();
+  if(l.eq(Min) or u.eq(Max)) return false;
+  if(l.getMinSignedBits() > 64 or u.getMinSignedBits() > 64) return false;
+  Lo = l.getSExtValue();
+  Hi = u.getSExtValue();
+  return true;
+}
@@ -24,6 +24,7 @@
 #include "llvm/IR/InstrTypes.h"
 #include "llvm/Support/raw_ostream.h"
 // libc includes
+#include <cstdint>
 #include <map>
 
 namespace llvm {
@@ -54,8 +55,9 @@ public:
   /// \brief Adds two offsets of the respective representation
   RAOffset* add(OffsetRepresentation* Other) override;
   
-  /// \brief Answers true if two offsets are disjoints
-  bool disjoint(OffsetRepresentation* Other) override;
+  /// \brief Answers true if the accessed byte intervals are disjoint
+  bool disjoint(OffsetRepresentation* Other, uint64_t Size, 
+    uint64_t OtherSize) override;
   
   /// \brief Narrows the offset of the respective representation
   RAOffset* narrow(CmpInst::Predicate Cmp, OffsetRepresentation* Other) override;
@@ -69,7 +71,15 @@ public:
   /// \brief Prints the offset to a file
   void print(raw_fd_ostream& fs) override;
 
-  void initialization(OffsetBasedAliasAnalysis* Analysis);
+  /// \brief Adds range analysis to the required analyses
+  static void getAnalysisUsage(AnalysisUsage &AU);
+  
+  /// \brief Fetches the range analysis from obaa
+  static void initialization(OffsetBasedAliasAnalysis* Analysis);
+  
+  /// \brief Gives the bounds range analysis found for the integer \p V.
+  /// Returns false if range analysis is not in use or \p V is unbounded.
+  static bool getValueBounds(const Value* V, int64_t& Lo, int64_t& Hi);
 
 private:
 
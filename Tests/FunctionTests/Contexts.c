@@ -0,0 +1,21 @@
+#include <stdlib.h>
+#include <stdio.h>
+
+/* Run with -obaa-context-depth=0 and then 1. Without contexts both calls
+   to advance return v1 + 1 or v2 + 1, so x and y may alias. With depth 1
+   each call gets the bases of its own argument and they do not. */
+
+char* advance(char* p) {
+  return p + 1;
+}
+
+int main (int argc, char** argv) {
+  char* v1 = (char*) malloc (5);
+  char* v2 = (char*) malloc (5);
+  char* x = advance(v1);
+  char* y = advance(v2);
+  x[0] = 'x';
+  y[0] = 'y';
+  printf("%c %c", x[0], y[0]);
+  return 0;
+}
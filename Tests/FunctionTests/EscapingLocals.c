@@ -0,0 +1,31 @@
+#include <stdlib.h>
+#include <stdio.h>
+
+/* With -obaa-escape only kept does not escape, so it is the only local
+   that the argument in cannot point to. The others are stored to a 
+   global, passed to a call that keeps them or turned into an integer. */
+
+char* saved;
+long address;
+
+void keep(char* p) {
+  saved = p;
+}
+
+void locals(char* in) {
+  char kept[8], stored[8], passed[8], cast[8];
+  saved = stored;
+  keep(passed);
+  address = (long) cast;
+  kept[0] = in[0];
+  stored[0] = in[1];
+  passed[0] = in[2];
+  cast[0] = in[3];
+  printf("%c %c %c %c", kept[0], stored[0], passed[0], cast[0]);
+}
+
+int main (int argc, char** argv) {
+  locals(argv[0]);
+  locals(saved);
+  return 0;
+}
@@ -0,0 +1,19 @@
+#include <stdlib.h>
+#include <stdio.h>
+
+struct node {
+  struct node* next;
+  char* data;
+};
+
+int main (int argc, char** argv) {
+  struct node nodes[4];
+  int i = argc % 4;
+  nodes[i].next = &nodes[0];
+  nodes[i].data = (char*) malloc (5);
+  char* d = nodes[i].data;
+  struct node* n = nodes[i].next;
+  d[4] = 'a';
+  printf("%c %p", d[4], n);
+  return 0;
+}
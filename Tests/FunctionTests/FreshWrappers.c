@@ -0,0 +1,21 @@
+#include <stdlib.h>
+#include <stdio.h>
+
+int* alloc(int s) {
+  return (int*) malloc(s*sizeof(int));
+}
+
+int* wrapAlloc(int s) {
+  if(s > 64)
+    return wrapAlloc(s/2);
+  return alloc(s);
+}
+
+int main (int argc, char** argv) {
+  int* a = wrapAlloc(argc);
+  int* b = wrapAlloc(argc);
+  a[0] = 1;
+  b[0] = 2;
+  
+  return a[0];
+}
@@ -0,0 +1,27 @@
+#include <stdlib.h>
+#include <stdio.h>
+
+char a[8], b[8];
+static char* const table[] = { a, b };
+
+struct handler {
+  const char* name;
+  char* buffer;
+};
+
+static const struct handler handlers[] = {
+  { "first", a },
+  { "second", b }
+};
+
+int main (int argc, char** argv) {
+  int i = argc % 2;
+  char* p = table[0];
+  char* q = table[1];
+  char* r = handlers[i].buffer;
+  p[0] = 'p';
+  q[0] = 'q';
+  r[1] = 'r';
+  printf("%c %c %s %c", p[0], q[0], handlers[i].name, r[1]);
+  return 0;
+}
@@ -0,0 +1,39 @@
+#include <stdlib.h>
+#include <stdio.h>
+
+/* Run with -obaa-context-depth=2 -obaa-heap-cloning, buffers from 
+   different calls to create_buffer get different bases. Without heap
+   cloning e and f share the malloc of create_buffer and may alias. */
+
+static char* last;
+
+char* create_buffer(int n, char* fallback) {
+  if(n <= 0)
+    return fallback;
+  char* b = (char*) malloc(n);
+  return b;
+}
+
+char* get_last() {
+  if(last == NULL)
+    last = (char*) malloc(16);
+  return last;
+}
+
+int main (int argc, char** argv) {
+  char x[8], y[8];
+  char* a = create_buffer(argc, argv[0]);
+  char* b = create_buffer(argc + 1, argv[0]);
+  char* c = get_last();
+  char* d = get_last();
+  char* e = create_buffer(argc, x);
+  char* f = create_buffer(argc + 1, y);
+  a[0] = 'a';
+  b[0] = 'b';
+  c[0] = 'c';
+  d[0] = 'd';
+  e[0] = 'e';
+  f[0] = 'f';
+  printf("%c %c %c %c %c %c", a[0], b[0], c[0], d[0], e[0], f[0]);
+  return 0;
+}
@@ -0,0 +1,26 @@
+#include <stdlib.h>
+#include <stdio.h>
+
+char* first(char* a, char* b) {
+  return a;
+}
+
+char* second(char* a, char* b) {
+  return b + 1;
+}
+
+void printFifths(char* a, char* b) {
+  char a5 = a[4];
+  char b5 = b[4];
+  printf("%c and %c", a5, b5);
+}
+
+int main (int argc, char** argv) {
+  char* (*pick)(char*, char*) = argc > 1 ? first : second;
+  void (*print)(char*, char*) = printFifths;
+  char* v1 = (char*) malloc (5);
+  char* v2 = (char*) malloc (6);
+  char* v3 = pick(v1, v2);
+  print(v1, v3);
+  return 0;
+}
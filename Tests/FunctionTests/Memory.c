@@ -0,0 +1,16 @@
+#include <stdlib.h>
+#include <stdio.h>
+
+int main (int argc, char** argv) {
+  char* slots[2];
+  char* v1 = (char*) malloc (5);
+  char* v2 = (char*) malloc (5);
+  slots[0] = v1;
+  slots[1] = v2;
+  char* a = slots[0];
+  char* b = slots[1];
+  a[4] = 'a';
+  b[4] = 'b';
+  printf("%c and %c", a[4], b[4]);
+  return 0;
+}
@@ -0,0 +1,18 @@
+#include <stdlib.h>
+#include <stdio.h>
+
+/* q is p grown to 100 bytes, so q[50] and q[i] are inside the object and
+   may alias, the 4 bytes p was allocated with do not bound q. */
+
+int main (int argc, char** argv) {
+  char* p = (char*) malloc (4);
+  p[0] = 'p';
+  char* q = (char*) realloc (p, 100);
+  int i = argc;
+  q[50] = 'q';
+  q[i] = 'i';
+  for(int j = 0; j < argc; j++)
+    q[j] = 'j';
+  printf("%c %c", q[50], q[i]);
+  return 0;
+}
@@ -0,0 +1,31 @@
+#include <stdlib.h>
+#include <stdio.h>
+
+/* dst and src are restrict, so they are bases of their own and do not
+   alias each other. p is passed by value, a copy other cannot point to.
+   argv is a plain argument now, it may alias what main loads from it. */
+
+struct pair {
+  char first[8];
+  char second[8];
+};
+
+void copyFirst(char* restrict dst, char* restrict src, struct pair p,
+char* other) {
+  dst[0] = src[0];
+  p.first[1] = other[1];
+  dst[2] = other[2];
+  printf("%c", p.first[1]);
+}
+
+int main (int argc, char** argv) {
+  struct pair p;
+  char* a = (char*) malloc (8);
+  char* b = (char*) malloc (8);
+  p.first[0] = 'p';
+  copyFirst(a, b, p, argv[0]);
+  char** args = argv + 1;
+  char* arg = argv[0];
+  args[0] = arg;
+  return a[0];
+}